@@ -0,0 +1,288 @@
+/**
+   MiracleGrue - Model Generator for toolpathing. <http://www.grue.makerbot.com>
+   Copyright (C) 2011 Far McKon <Far@makerbot.com>, Hugo Boyer (hugo@makerbot.com)
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Affero General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+ */
+
+/*
+ Times every stage of the pipeline on one model and prints the timings
+ as JSON: wall time, items handled per second and the peak resident size
+ of the process after each stage. The sub-stages of generateSkeleton are
+ timed from the progress the regioner reports.
+
+ Peak resident size only grows, so each model gets a process of its own.
+ The model can be scaled first, to see how stages grow with model size.
+
+ usage: PipelineBenchmark -c config [-s scale] [-o result.json]
+         [-g output.gcode] model.stl
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iterator>
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include <json/value.h>
+#include <json/writer.h>
+
+#include "mgl/abstractable.h"
+#include "mgl/configuration.h"
+#include "mgl/meshy.h"
+#include "mgl/segmenter.h"
+#include "mgl/slicer.h"
+#include "mgl/loop_processor.h"
+#include "mgl/regioner.h"
+#include "mgl/pather.h"
+#include "mgl/gcoder.h"
+
+using namespace std;
+using namespace mgl;
+
+/// seconds since some fixed point in the past
+static double wallSeconds() {
+#ifdef _WIN32
+	LARGE_INTEGER frequency, now;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&now);
+	return double(now.QuadPart) / double(frequency.QuadPart);
+#else
+	timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec + now.tv_usec * 1e-6;
+#endif
+}
+
+/// largest resident size of this process so far, in KB, -1 if unknown
+static Json::Value peakRssKb() {
+#ifdef _WIN32
+	return Json::Value(-1);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return Json::Value(-1);
+#ifdef __APPLE__
+	//bytes on Mac, KB elsewhere
+	return Json::Value(Json::Int(usage.ru_maxrss / 1024));
+#else
+	return Json::Value(Json::Int(usage.ru_maxrss));
+#endif
+#endif
+}
+
+/// Stage record with throughput, for @a count @a unit since @a start
+static Json::Value stage(const char* name, double start,
+		size_t count, const char* unit) {
+	double seconds = wallSeconds() - start;
+	Json::Value result;
+	result["name"] = name;
+	result["seconds"] = seconds;
+	result["count"] = Json::UInt(count);
+	result["unit"] = unit;
+	result["perSecond"] = seconds > 0 ? count / seconds : 0.0;
+	result["peakRssKb"] = peakRssKb();
+	return result;
+}
+
+/**
+ Progress bar that notes when each named task starts ticking. Stages
+ report progress at the top of their loops, so the time from one task
+ starting to the next is the time spent in the first.
+ */
+class StageTimer : public ProgressBar {
+public:
+	StageTimer() : count(0), start(0) {}
+	void onTick(const char* taskName, unsigned int size, unsigned int it) {
+		if (it != 0)
+			return;
+		finish();
+		current = taskName;
+		count = size;
+		start = wallSeconds();
+	}
+	/// close the task in progress, if any
+	void finish() {
+		if (current.empty())
+			return;
+		stages.append(stage(current.c_str(), start, count, "layers"));
+		current.clear();
+	}
+	Json::Value stages;
+private:
+	std::string current;
+	unsigned int count;
+	double start;
+};
+
+/// Write @a modelFile scaled by @a scale about the origin to @a scaledFile
+static void scaleModel(const GrueConfig& grueCfg, const string& modelFile,
+		Scalar scale, const string& scaledFile) {
+	Meshy mesh(grueCfg);
+	mesh.readStlFile(modelFile.c_str());
+	Meshy scaled(grueCfg);
+	const std::vector<Triangle3Type>& triangles = mesh.readAllTriangles();
+	for (std::vector<Triangle3Type>::const_iterator iter = triangles.begin();
+			iter != triangles.end();
+			++iter) {
+		Triangle3Type t((*iter)[0] * scale, (*iter)[1] * scale,
+				(*iter)[2] * scale);
+		scaled.addTriangle(t);
+	}
+	scaled.writeStlFile(scaledFile.c_str());
+}
+
+/// Run the whole pipeline on @a modelFile, timing each stage
+static Json::Value benchmark(const GrueConfig& grueCfg,
+		const string& modelFile, const string& gcodeFile) {
+	Json::Value result;
+	Json::Value& stages = result["stages"];
+	double begin = wallSeconds();
+	double start;
+
+	Limits limits;
+	Grid grid;
+	LayerLoops layerloops(grueCfg.get_firstLayerZ(), grueCfg.get_layerH());
+	{
+		Meshy mesh(grueCfg);
+		start = wallSeconds();
+		mesh.readStlFile(modelFile.c_str());
+		mesh.alignToPlate();
+		size_t triangleCount = mesh.readAllTriangles().size();
+		stages.append(stage("readStlFile", start, triangleCount, "triangles"));
+		result["triangles"] = Json::UInt(triangleCount);
+		limits = mesh.readLimits();
+
+		Segmenter segmenter(grueCfg);
+		start = wallSeconds();
+		segmenter.tablaturize(mesh);
+		stages.append(stage("tablaturize", start, triangleCount, "triangles"));
+
+		Slicer slicer(grueCfg);
+		start = wallSeconds();
+		slicer.generateLoops(segmenter, layerloops);
+		stages.append(stage("generateLoops", start,
+				segmenter.sliceCount(), "slices"));
+	}
+
+	LayerLoops processedLoops;
+	LoopProcessor processor(grueCfg);
+	start = wallSeconds();
+	processor.processLoops(layerloops, processedLoops);
+	stages.append(stage("processLoops", start, processedLoops.size(),
+			"layers"));
+	layerloops.erase(layerloops.begin(), layerloops.end());
+	LayerMeasure& layerMeasure = processedLoops.layerMeasure;
+
+	StageTimer skeletonTimer;
+	Regioner regioner(grueCfg, &skeletonTimer);
+	RegionList regions;
+	start = wallSeconds();
+	regioner.generateSkeleton(processedLoops, layerMeasure, regions,
+			limits, grid);
+	skeletonTimer.finish();
+	Json::Value skeleton = stage("generateSkeleton", start, regions.size(),
+			"layers");
+	skeleton["stages"] = skeletonTimer.stages;
+	stages.append(skeleton);
+	processedLoops.erase(processedLoops.begin(), processedLoops.end());
+	result["layers"] = Json::UInt(regions.size());
+
+	Pather pather(grueCfg);
+	LayerPaths layers;
+	start = wallSeconds();
+	pather.generatePaths(grueCfg, regions, layerMeasure, grid, layers);
+	size_t layerCount = std::distance(layers.begin(), layers.end());
+	stages.append(stage("generatePaths", start, layerCount, "layers"));
+
+	GCoder gcoder(grueCfg);
+	std::ofstream gout(gcodeFile.c_str());
+	start = wallSeconds();
+	gcoder.writeGcodeFile(layers, layerMeasure, gout, modelFile);
+	gout.flush();
+	stages.append(stage("writeGcodeFile", start, layerCount, "layers"));
+
+	result["seconds"] = wallSeconds() - begin;
+	result["peakRssKb"] = peakRssKb();
+	return result;
+}
+
+static void usage() {
+	cerr << "usage: PipelineBenchmark -c config [-s scale] "
+			"[-o result.json] [-g output.gcode] model.stl" << endl;
+	exit(-1);
+}
+
+int main(int argc, char *argv[]) {
+	string configFile;
+	string resultFile;
+	string gcodeFile = "benchmark.gcode";
+	string modelFile;
+	Scalar scale = 1.0;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg.size() == 2 && arg[0] == '-' && i + 1 < argc) {
+			const char* value = argv[++i];
+			switch (arg[1]) {
+			case 'c': configFile = value; break;
+			case 'o': resultFile = value; break;
+			case 'g': gcodeFile = value; break;
+			case 's': scale = atof(value); break;
+			default: usage();
+			}
+		} else if (modelFile.empty()) {
+			modelFile = arg;
+		} else {
+			usage();
+		}
+	}
+	if (configFile.empty() || modelFile.empty() || scale <= 0)
+		usage();
+
+	try {
+		Configuration config;
+		config.readFromFile(configFile.c_str());
+		GrueConfig grueCfg;
+		grueCfg.loadFromFile(config);
+
+		string inputFile = modelFile;
+		if (scale != 1.0) {
+			MyComputer computer;
+			inputFile = computer.fileSystem.ChangeExtension(
+					gcodeFile.c_str(), ".scaled.stl");
+			scaleModel(grueCfg, modelFile, scale, inputFile);
+		}
+
+		Json::Value result = benchmark(grueCfg, inputFile, gcodeFile);
+		result["model"] = modelFile;
+		result["scale"] = scale;
+		result["config"] = configFile;
+		result["threadCount"] = grueCfg.get_threadCount();
+
+		Json::StyledWriter writer;
+		if (resultFile.empty()) {
+			cout << writer.write(result);
+		} else {
+			std::ofstream out(resultFile.c_str());
+			out << writer.write(result);
+		}
+	} catch (const mgl::Exception& mixup) {
+		cerr << "ERROR: " << mixup.error << endl;
+		return -1;
+	}
+	return 0;
+}
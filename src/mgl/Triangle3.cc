@@ -102,14 +102,6 @@ Vector3 Triangle3::normal() const
 }
 
 
-// Returns a vector that points in the
-// direction of the cut, using the
-// right hand normal.
-Vector3 Triangle3::cutDirection() const
-{
-	return cutDir;
-}
-
 //
 // Sorts the 3 points in assending order
 //
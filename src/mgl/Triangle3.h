@@ -31,6 +31,9 @@ public:
 
 	Vector3 operator[](unsigned int i) const;
 
+	// the points, by number, without the range check of operator[]
+	const Vector3& v(unsigned int i) const { return i == 0 ? v0 : (i == 1 ? v1 : v2); }
+
 	Triangle3& operator= (const Triangle3& other);
 
     /// tolerance equals of this vector vs passed vector p
@@ -44,7 +47,7 @@ public:
 	// Returns a vector that points in the
 	// direction of the cut, using the
 	// right hand normal.
-	Vector3 cutDirection() const;
+	Vector3 cutDirection() const { return cutDir; }
 	//
 	// Sorts the 3 points in assending order
 	//
@@ -52,6 +52,8 @@ namespace mgl {
  void insert(const value_type& value);  //store a copy of value in this index
  template <typename CONTAINER, typename FILTER>
  void search(CONTAINER& result, const FILTER& filt); //query container
+ template <typename FILTER, typename PREDICATE>
+ bool any(const FILTER& filt, const PREDICATE& pred); //early out query
  void swap(spacial_index& other);   //fast swap implementation
  
  */
@@ -140,6 +142,21 @@ public:
                 result.push_back(iter->first);
         }
     }
+    /*!Test if any value that meets the criteria of filt.filter(AABBox) 
+     also satisfies pred(value). Stops at the first one that does.
+     @filter: object supporting filter(...) that defines the criteria
+     @pred: object supporting bool operator()(const value_type&) const
+     @return: true if such a value was found*/
+    template <typename FILTER, typename PREDICATE>
+    bool any(const FILTER& filt, const PREDICATE& pred) const {
+        for(typename internal_container::const_iterator iter = data.begin(); 
+                iter != data.end(); 
+                ++iter) {
+            if(filt.filter(iter->second) && pred(iter->first))
+                return true;
+        }
+        return false;
+    }
     /*!Swap contents of this object with that of another
      @other: The object with which to swap contents
      In general, this should be a constant time swap that involves 
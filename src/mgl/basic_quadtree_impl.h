@@ -79,6 +79,25 @@ void basic_quadtree<T>::search(COLLECTION& result, const FILTER& filt) const {
         }
 }
 template <typename T>
+template <typename FILTER, typename PREDICATE>
+bool basic_quadtree<T>::any(const FILTER& filt, 
+        const PREDICATE& pred) const {
+    if(!filt.filter(myBounds))
+        return false;
+    for(typename data_container::const_iterator iter = myData.begin(); 
+            iter != myData.end(); 
+            ++iter) {
+        if(filt.filter(iter->first) && pred(*(iter->second)))
+            return true;
+    }
+    if(hasChildren())
+        for(size_t i = 0; i < CAPACITY; ++i) {
+            if(myChildren[i]->any(filt, pred))
+                return true;
+        }
+    return false;
+}
+template <typename T>
 void basic_quadtree<T>::swap(basic_quadtree& other) {
     //swap all pointers, primitives, and POD's
     std::swap(myBounds, other.myBounds);
@@ -87,6 +87,8 @@ static const size_t RTREE_DEFAULT_BRANCH = 4;
  void insert(const value_type& value);  //store a copy of value in this index
  template <typename CONTAINER, typename FILTER>
  void search(CONTAINER& result, const FILTER& filt); //query container
+ template <typename FILTER, typename PREDICATE>
+ bool any(const FILTER& filt, const PREDICATE& pred); //early out query
  void swap(spacial_index& other);   //fast swap implementation
  
  */
@@ -129,6 +131,13 @@ public:
      the filter are placed in result.*/
     template <typename COLLECTION, typename FILTER>
     void search(COLLECTION& result, const FILTER& filt) const;
+    /*!Test if any value that meets the criteria of filt.filter(AABBox) 
+     also satisfies pred(value). Stops at the first one that does.
+     @filter: object supporting filter(...) that defines the criteria
+     @pred: object supporting bool operator()(const value_type&) const
+     @return: true if such a value was found*/
+    template <typename FILTER, typename PREDICATE>
+    bool any(const FILTER& filt, const PREDICATE& pred) const;
     /*!Swap contents of this object with that of another
      @other: The object with which to swap contents
      In general, this should be a constant time swap that involves 
@@ -151,6 +160,8 @@ private:
     
     template <typename COLLECTION, typename FILTER>
     void searchPrivate(COLLECTION& result, const FILTER& filt, DIAG& diag) const;
+    template <typename FILTER, typename PREDICATE>
+    bool anyPrivate(const FILTER& filt, const PREDICATE& pred, DIAG& diag) const;
 
 
     explicit basic_rtree(const value_type& value);
@@ -121,6 +121,27 @@ void RTREE_TYPE::searchPrivate(COLLECTION& result,
     }
 }
 RTREE_TEMPLATE
+template <typename FILTER, typename PREDICATE>
+bool RTREE_TYPE::any(const FILTER& filt, const PREDICATE& pred) const {
+    DIAG diag("Any");
+    return anyPrivate(filt, pred, diag);
+}
+RTREE_TEMPLATE
+template <typename FILTER, typename PREDICATE>
+bool RTREE_TYPE::anyPrivate(const FILTER& filt, 
+        const PREDICATE& pred, DIAG& diag) const {
+    RTREE_DIAG_CALL(diag, addOperations, 1);
+    if(!filt.filter(myBounds))
+        return false;
+    if(isLeaf())
+        return pred(*myData);
+    for(size_t i = 0; i < size(); ++i) {
+        if(myChildren[i]->anyPrivate(filt, pred, diag))
+            return true;
+    }
+    return false;
+}
+RTREE_TEMPLATE
 void RTREE_TYPE::swap(basic_rtree& other) {
     //swap all pointers, primitives, and POD's
     std::swap(splitMyself, other.splitMyself);
@@ -0,0 +1,299 @@
+/**
+   MiracleGrue - Model Generator for toolpathing. <http://www.grue.makerbot.com>
+   Copyright (C) 2011 Far McKon <Far@makerbot.com>, Hugo Boyer (hugo@makerbot.com)
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Affero General Public License as
+   published by the Free Software Foundation, either version 3 of the
+   License, or (at your option) any later version.
+
+ */
+
+#ifndef MGL_BASIC_STRTREE_H
+#define	MGL_BASIC_STRTREE_H
+
+#include "spacial_data.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace mgl {
+
+static const size_t STRTREE_DEFAULT_BRANCH = 8;
+
+/*
+ basic_strtree implements the interface for a spacial index.
+ A spacial index is a class that contains two-dimensional objects and
+ allows queries for these objects based on their location and geometry.
+
+ Internally, spacial data structures work on AABBox (axis aligned
+ bounding box). They must be able to construct a bounding box for
+ the type that they contain. This is done by calling the static function
+ AABBox boundingBox = to_bbox<value_type>::bound(value);
+
+ YOU MUST PROVIDE A TEMPLATE SPECIALIZATION FOR to_bbox<>::bound(...);
+ following this form:
+ template <>
+ struct to_bbox<YourType> {
+    static AABBox bound(const YourType&) {
+        //see spacial_data.h for interface to AABBox
+    }
+ }
+
+ Spacial indexes are safe to copy construct and assign. They store copies
+ of all things inserted into them and fill search results with copies of
+ their contents. You may have an index of pointers if you implement
+ the correct specialization of to_bbox.
+
+ Spacial data structures may be queried by calling search(collection, filter)
+ collection is any object that supports push_back(const value_type&). This
+ would usually be a list or vector of the same type as the spacial index.
+ filter is any object with a function bool object::filter(const AABBox&) const;
+ This function should return true for bounding boxes that meet the criteria of
+ what you wish to search for, and false otherwise.
+
+ Removal from spacial indexes is not universally implemented yet.
+
+ Interface methods:
+
+ void insert(const value_type& value);  //store a copy of value in this index
+ template <typename CONTAINER, typename FILTER>
+ void search(CONTAINER& result, const FILTER& filt); //query container
+ template <typename FILTER, typename PREDICATE>
+ bool any(const FILTER& filt, const PREDICATE& pred); //early out query
+ void swap(spacial_index& other);   //fast swap implementation
+
+ Unlike basic_rtree, this tree is not grown one insertion at a time.
+ Insertions are only collected, and the first query after them packs
+ everything with Sort-Tile-Recursive into full nodes stored level by
+ level in flat arrays. This suits indexes that are filled once and then
+ queried many times. Because queries may pack the tree, do not query
+ the same index from several threads until it has been queried once.
+
+ */
+
+template <typename T, size_t C = STRTREE_DEFAULT_BRANCH>
+class basic_strtree {
+public:
+    typedef T value_type;
+    typedef std::pair<value_type, AABBox> value_bounds;
+
+    typedef std::vector<value_bounds> internal_container;
+
+    template <typename BASE>
+    class basic_iterator {
+        friend class basic_strtree;
+    public:
+        basic_iterator& operator++() { ++m_base; return *this; }
+        basic_iterator operator++(int) { basic_iterator copy = *this; ++*this; return copy; }
+        bool operator== (const basic_iterator& rhs) { return m_base ==  rhs.m_base; }
+        bool operator!= (const basic_iterator& rhs) { return !(*this==rhs); }
+        const typename BASE::value_type::first_type& operator* () { return m_base->first; }
+        const typename BASE::value_type::first_type* operator-> () { return &**this; }
+    private:
+        basic_iterator(BASE base) : m_base(base) {}
+        BASE m_base;
+    };
+
+    typedef basic_iterator<typename internal_container::const_iterator> iterator;
+    typedef iterator const_iterator;
+
+    basic_strtree() : m_packed(true) {}
+
+    /*!Insert a value into the spacial index
+     @value: a const reference of what should be inserted.
+     a copy of this will be stored.
+     @return: an iterator to what you just inserted (not implemented)*/
+    iterator insert(const value_type& value) {
+        m_data.push_back(value_bounds(value,
+                to_bbox<value_type>::bound(value)));
+        m_packed = false;
+        return end();
+    }
+    /*!Search for values that meet criteria of filt.filter(AABBox)
+     @result: Object supporting push_back(...) where output is placed
+     @filter: object supporting filter(...) that defines the criteria
+     Contents of index are not modified, copies of values that pass
+     the filter are placed in result.*/
+    template <typename COLLECTION, typename FILTER>
+    void search(COLLECTION& result, const FILTER& filt) const {
+        collector<COLLECTION> visitor(result);
+        visit(filt, visitor);
+    }
+    /*!Test if any value that meets the criteria of filt.filter(AABBox)
+     also satisfies pred(value). Stops at the first one that does.
+     @filter: object supporting filter(...) that defines the criteria
+     @pred: object supporting bool operator()(const value_type&) const
+     @return: true if such a value was found*/
+    template <typename FILTER, typename PREDICATE>
+    bool any(const FILTER& filt, const PREDICATE& pred) const {
+        finder<PREDICATE> visitor(pred);
+        return visit(filt, visitor);
+    }
+    /*!Swap contents of this object with that of another
+     @other: The object with which to swap contents
+     In general, this should be a constant time swap that involves
+     no copying of data elements*/
+    void swap(basic_strtree& other) {
+        m_data.swap(other.m_data);
+        m_levels.swap(other.m_levels);
+        std::swap(m_packed, other.m_packed);
+    }
+    const_iterator begin() const { return const_data().begin(); }
+    const_iterator end() const { return const_data().end(); }
+    size_t size() const { return m_data.size(); }
+    bool empty() const { return m_data.empty(); }
+
+private:
+    /// a tree node, covering children [first, first + count) one level down
+    class node {
+    public:
+        node(const AABBox& bounds = AABBox(), size_t first = 0,
+                size_t count = 0)
+                : m_bounds(bounds), m_first(first), m_count(count) {}
+        AABBox m_bounds;
+        size_t m_first;
+        size_t m_count;
+    };
+    const internal_container& const_data() const { return m_data; }
+    typedef std::vector<node> level_type;
+    typedef std::vector<level_type> level_container;
+
+    template <typename COLLECTION>
+    class collector {
+    public:
+        collector(COLLECTION& result) : m_result(result) {}
+        bool operator()(const value_type& value) const {
+            m_result.push_back(value);
+            return false;
+        }
+    private:
+        COLLECTION& m_result;
+    };
+    template <typename PREDICATE>
+    class finder {
+    public:
+        finder(const PREDICATE& pred) : m_pred(pred) {}
+        bool operator()(const value_type& value) const {
+            return m_pred(value);
+        }
+    private:
+        const PREDICATE& m_pred;
+    };
+    static const AABBox& boundsOf(const node& entry) {
+        return entry.m_bounds;
+    }
+    static const AABBox& boundsOf(const value_bounds& entry) {
+        return entry.second;
+    }
+
+    template <typename ENTRY>
+    class center_less {
+    public:
+        center_less(bool alongX) : m_alongX(alongX) {}
+        bool operator()(const ENTRY& lhs, const ENTRY& rhs) const {
+            const AABBox& lb = boundsOf(lhs);
+            const AABBox& rb = boundsOf(rhs);
+            return m_alongX ?
+                    lb.m_min.x + lb.m_max.x < rb.m_min.x + rb.m_max.x :
+                    lb.m_min.y + lb.m_max.y < rb.m_min.y + rb.m_max.y;
+        }
+    private:
+        bool m_alongX;
+    };
+    /**
+     @brief Sort-Tile-Recursive ordering of one level: cut the entries
+     into vertical slices by center x, then sort each slice by center y,
+     so each run of C entries is spacially compact
+     */
+    template <typename ENTRY>
+    static void tile(std::vector<ENTRY>& entries) {
+        typedef typename std::vector<ENTRY>::iterator iterator;
+        size_t nodeCount = (entries.size() + C - 1) / C;
+        size_t sliceCount = 1;
+        while(sliceCount * sliceCount < nodeCount)
+            ++sliceCount;
+        size_t sliceSize = ((nodeCount + sliceCount - 1) / sliceCount) * C;
+        std::sort(entries.begin(), entries.end(), center_less<ENTRY>(true));
+        for(size_t first = 0; first < entries.size(); first += sliceSize) {
+            iterator begin = entries.begin() + first;
+            iterator end = entries.begin() +
+                    std::min(first + sliceSize, entries.size());
+            std::sort(begin, end, center_less<ENTRY>(false));
+        }
+    }
+    /// group consecutive runs of C entries into the nodes of a new level
+    template <typename ENTRY>
+    static void group(const std::vector<ENTRY>& entries, level_type& parents) {
+        parents.clear();
+        parents.reserve((entries.size() + C - 1) / C);
+        for(size_t first = 0; first < entries.size(); first += C) {
+            size_t count = std::min(C, entries.size() - first);
+            node parent(boundsOf(entries[first]), first, count);
+            for(size_t i = first + 1; i < first + count; ++i)
+                parent.m_bounds.expandTo(boundsOf(entries[i]));
+            parents.push_back(parent);
+        }
+    }
+    /// pack everything inserted so far, root level last
+    void pack() const {
+        m_levels.clear();
+        if(!m_data.empty()) {
+            tile(m_data);
+            m_levels.push_back(level_type());
+            group(m_data, m_levels.back());
+            while(m_levels.back().size() > 1) {
+                tile(m_levels.back());
+                level_type parents;
+                group(m_levels.back(), parents);
+                m_levels.push_back(level_type());
+                m_levels.back().swap(parents);
+            }
+        }
+        m_packed = true;
+    }
+    /**
+     @brief hand every value passing @a filt to @a visitor until it
+     returns true
+     @return true if @a visitor stopped the search
+     */
+    template <typename FILTER, typename VISITOR>
+    bool visit(const FILTER& filt, const VISITOR& visitor) const {
+        if(!m_packed)
+            pack();
+        if(m_levels.empty())
+            return false;
+        //(level, node) pairs still to open, level 0 nodes hold values
+        std::vector<std::pair<size_t, size_t> > pending;
+        pending.push_back(std::make_pair(m_levels.size() - 1, size_t(0)));
+        while(!pending.empty()) {
+            std::pair<size_t, size_t> current = pending.back();
+            pending.pop_back();
+            const node& open = m_levels[current.first][current.second];
+            if(!filt.filter(open.m_bounds))
+                continue;
+            size_t last = open.m_first + open.m_count;
+            if(current.first == 0) {
+                for(size_t i = open.m_first; i < last; ++i) {
+                    if(filt.filter(m_data[i].second) &&
+                            visitor(m_data[i].first))
+                        return true;
+                }
+            } else {
+                for(size_t i = last; i-- > open.m_first;) {
+                    pending.push_back(std::make_pair(current.first - 1, i));
+                }
+            }
+        }
+        return false;
+    }
+
+    mutable internal_container m_data;
+    mutable level_container m_levels;
+    mutable bool m_packed;
+};
+
+}
+
+#endif	/* MGL_BASIC_STRTREE_H */
+
@@ -190,9 +190,11 @@ GrueConfig::GrueConfig()
         doFanCommand(INVALID_BOOL), fanLayer(INVALID_UINT), 
         doAnchor(INVALID_BOOL), doPutModelOnPlatform(INVALID_BOOL), 
         doPrintLayerMessages(INVALID_BOOL), doPrintProgress(INVALID_BOOL), 
+        doMoveComments(true), // moves were always commented before the key
         minLayerDuration(INVALID_SCALAR), 
         coarseness(INVALID_SCALAR), preCoarseness(INVALID_SCALAR), 
-        directionWeight(INVALID_SCALAR), 
+        directionWeight(INVALID_SCALAR), threadCount(INVALID_UINT), 
+        strictStl(INVALID_BOOL), streamLayers(INVALID_BOOL), 
         layerH(INVALID_SCALAR), firstLayerZ(INVALID_SCALAR), 
         infillDensity(INVALID_SCALAR), nbOfShells(INVALID_UINT), 
         layerWidthRatio(INVALID_SCALAR), layerWidthMinimum(INVALID_SCALAR), 
@@ -214,7 +216,8 @@ GrueConfig::GrueConfig()
         raftInterfaceThickness(INVALID_SCALAR), raftOutset(INVALID_SCALAR), 
         raftModelSpacing(INVALID_SCALAR), raftDensity(INVALID_SCALAR), 
         doSupport(INVALID_BOOL), supportMargin(INVALID_SCALAR), 
-        supportDensity(INVALID_SCALAR), doGraphOptimization(INVALID_BOOL), 
+        supportDensity(INVALID_SCALAR), supportTolerance(INVALID_SCALAR), 
+        doGraphOptimization(INVALID_BOOL), 
         rapidMoveFeedRateXY(INVALID_SCALAR), rapidMoveFeedRateZ(INVALID_SCALAR), 
         useEaxis(INVALID_BOOL), 
         /*
@@ -251,6 +254,12 @@ void GrueConfig::loadSlicingParams(const Configuration& config) {
             config["preCoarseness"], "preCoarseness"));
     directionWeight = doubleCheck(config["directionWeight"],
             "directionWeight", 0.5);
+    threadCount = uintCheck(config["threadCount"], 
+            "threadCount", 0);
+    strictStl = boolCheck(config["strictStl"], 
+            "strictStl", false);
+    streamLayers = boolCheck(config["streamLayers"], 
+            "streamLayers", false);
     layerH = (doubleCheck(
             config["layerHeight"], "layerHeight"));
     firstLayerZ = doubleCheck(config["bedZOffset"], 
@@ -340,6 +349,9 @@ void GrueConfig::loadGcodeParams(const Configuration& config) {
     doPrintProgress = boolCheck(
             config["doPrintProgress"],
             "doPrintProgress", false);
+    doMoveComments = boolCheck(
+            config["doMoveComments"],
+            "doMoveComments", true);
     minLayerDuration = doubleCheck(
             config["minLayerDuration"], 
             "minLayerDuration", 0);
@@ -374,6 +386,8 @@ void GrueConfig::loadSupportParams(const Configuration& config) {
                 "supportMargin");
     supportDensity = doubleCheck(
             config["supportDensity"], "supportDensity");
+    supportTolerance = doubleCheck(
+            config["supportTolerance"], "supportTolerance", 0.05);
 }
 void GrueConfig::loadPathingParams(const Configuration& config) {
 }
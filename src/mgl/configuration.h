@@ -182,10 +182,14 @@ private:
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doPutModelOnPlatform)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doPrintLayerMessages)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doPrintProgress)
+    GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doMoveComments)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, minLayerDuration)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, coarseness)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, preCoarseness)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, directionWeight)
+    GRUECONFIG_PUBLIC_CONST_ACCESSOR(unsigned, threadCount)
+    GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, strictStl)
+    GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, streamLayers)
     //slicer
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, layerH)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, firstLayerZ)
@@ -219,6 +223,7 @@ private:
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doSupport)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, supportMargin)
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, supportDensity)
+    GRUECONFIG_PUBLIC_CONST_ACCESSOR(Scalar, supportTolerance)
     //pather
     GRUECONFIG_PUBLIC_CONST_ACCESSOR(bool, doGraphOptimization)
     //gantry
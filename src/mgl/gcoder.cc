@@ -73,7 +73,7 @@ void polygonLeadInAndLeadOut(const mgl::Polygon &polygon, const Extruder &extrud
 GCoder::GCoder(const GrueConfig& grueConf, ProgressBar* progress)
         : Progressive(progress), grueCfg(grueConf), gantry(grueCfg), 
         progressTotal(0), progressCurrent(0), 
-        progressPercent(0) {
+        progressPercent(0), progressByLayer(false), nextLayer(0) {
     gantry.init_to_start();
 }
 
@@ -159,7 +159,7 @@ void GCoder::writeProgressPercent(std::ostream& ss, unsigned int current,
         ss << "M73 P" << curPercent << " " << grueCfg.get_commentOpen()
            << "progress (" << curPercent << "%): " << current 
                 << "/" << total << 
-            grueCfg.get_commentClose() << std::endl;
+            grueCfg.get_commentClose() << '\n';
         progressPercent = curPercent;
     }
 }
@@ -236,7 +236,8 @@ void GCoder::writeGcodeFile(LayerPaths& layerpaths,
         std::ostream& gout,
         const std::string& title,
         LayerPaths::layer_iterator begin,
-        LayerPaths::layer_iterator end) {
+        LayerPaths::layer_iterator end,
+        size_t firstLayer) {
     writeStartDotGCode(gout, title.c_str());
     size_t sliceCount = 0;
     progressTotal = 1;
@@ -258,48 +259,74 @@ void GCoder::writeGcodeFile(LayerPaths& layerpaths,
         }
     }
     initProgress("gcode", sliceCount);
-    size_t layerSequence = 0;
-    for (LayerPaths::layer_iterator it = begin;
-            it != end; ++it, ++layerSequence) {
-        tick();
-        //Scalar z = layerMeasure.sliceIndexToHeight(codeSlice);
-        if(grueCfg.get_doAnchor() && layerSequence == 0) {
-            Extrusion strusion;
-            PathLabel slabel(PathLabel::TYP_CONNECTION, PathLabel::OWN_MODEL, 0);
-            const Extruder& struder = grueCfg.get_extruders()[
-                    it->extruders.front().extruderId];
-            calcExtrusion(struder.id, 0, slabel, strusion);
-            gantry.set_current_extruder_index(struder.code);
-            Point2Type startPoint;
-            if(!it->extruders.empty() && 
-                    !it->extruders.front().paths.empty() && 
-                    !it->extruders.front().paths.front().myPath.empty()) {
-                startPoint = *(it->extruders.front().paths.front().myPath.fromStart());
-            }
-            gantry.snort(gout, struder, 
-                    strusion);
-            const Scalar currentZ = it->layerZ + it->layerHeight;
-            const Scalar currentH = it->layerHeight;
-            const Scalar currentW = it->layerW * 2.0;
-            gantry.g1(gout, struder, 
-                    strusion, grueCfg.get_startingX(), 
-                    grueCfg.get_startingY(), currentZ, 
-                    strusion.feedrate, 
-                    currentH, currentW, "Anchor Start");
-            gantry.squirt(gout, struder, 
-                    strusion);
-            gantry.g1(gout, struder, 
-                    strusion, grueCfg.get_startingX(), 
-                    grueCfg.get_startingY(), currentZ, 
-                    strusion.feedrate, 
-                    currentH, currentW, "Anchor Start");
-            gantry.g1(gout, struder, 
-                    strusion, startPoint.x, startPoint.y, currentZ, 
-                    strusion.feedrate, 
-                    currentH, currentW, "Anchor End");
+    progressByLayer = false;
+    nextLayer = firstLayer;
+    for (LayerPaths::layer_iterator it = begin; it != end; ++it) {
+        writeLayer(gout, layerpaths, it);
+    }
+    endGcode(gout);
+}
+
+void GCoder::beginGcode(std::ostream& gout,
+        const std::string& title,
+        size_t layerCount,
+        size_t firstLayer) {
+    writeStartDotGCode(gout, title.c_str());
+    progressTotal = layerCount ? layerCount : 1;
+    progressCurrent = 0;
+    progressPercent = 0;
+    progressByLayer = true;
+    nextLayer = firstLayer;
+    initProgress("gcode", layerCount);
+}
+
+void GCoder::writeLayer(std::ostream& gout,
+        LayerPaths& layerpaths,
+        LayerPaths::layer_iterator it) {
+    size_t layerSequence = nextLayer++;
+    tick();
+    if(progressByLayer)
+        writeProgressPercent(gout, ++progressCurrent, progressTotal);
+    //Scalar z = layerMeasure.sliceIndexToHeight(codeSlice);
+    if(grueCfg.get_doAnchor() && layerSequence == 0) {
+        Extrusion strusion;
+        PathLabel slabel(PathLabel::TYP_CONNECTION, PathLabel::OWN_MODEL, 0);
+        const Extruder& struder = grueCfg.get_extruders()[
+                it->extruders.front().extruderId];
+        calcExtrusion(struder.id, 0, slabel, strusion);
+        gantry.set_current_extruder_index(struder.code);
+        Point2Type startPoint;
+        if(!it->extruders.empty() && 
+                !it->extruders.front().paths.empty() && 
+                !it->extruders.front().paths.front().myPath.empty()) {
+            startPoint = *(it->extruders.front().paths.front().myPath.fromStart());
         }
-        writeSlice(gout, layerpaths, it, layerSequence);
+        gantry.snort(gout, struder, 
+                strusion);
+        const Scalar currentZ = it->layerZ + it->layerHeight;
+        const Scalar currentH = it->layerHeight;
+        const Scalar currentW = it->layerW * 2.0;
+        gantry.g1(gout, struder, 
+                strusion, grueCfg.get_startingX(), 
+                grueCfg.get_startingY(), currentZ, 
+                strusion.feedrate, 
+                currentH, currentW, "Anchor Start");
+        gantry.squirt(gout, struder, 
+                strusion);
+        gantry.g1(gout, struder, 
+                strusion, grueCfg.get_startingX(), 
+                grueCfg.get_startingY(), currentZ, 
+                strusion.feedrate, 
+                currentH, currentW, "Anchor Start");
+        gantry.g1(gout, struder, 
+                strusion, startPoint.x, startPoint.y, currentZ, 
+                strusion.feedrate, 
+                currentH, currentW, "Anchor End");
     }
+    writeSlice(gout, layerpaths, it, layerSequence);
+}
+
+void GCoder::endGcode(std::ostream& gout) {
     if(grueCfg.get_doFanCommand()) {
         //print command to disable fan
         if (grueCfg.get_weightedFanCommand() != -1)
@@ -14,6 +14,7 @@
 #define GCODER_H_
 
 #include <map>
+#include <cstdio>
 #include "configuration.h"
 #include "mgl.h"
 #include "pather.h"
@@ -88,6 +89,8 @@ public:
     unsigned int progressTotal;    //how many paths we will be doing
     unsigned int progressCurrent;  //which path the current one is
     unsigned int progressPercent;
+    bool progressByLayer;          //count progress in layers, not paths
+    size_t nextLayer;              //sequence number of the next layer
 
     GCoder(const GrueConfig& grueConf, ProgressBar* progress = NULL);
 
@@ -112,7 +115,26 @@ public:
             std::ostream& gout,
             const std::string& title,
             LayerPaths::layer_iterator begin,
-            LayerPaths::layer_iterator end);
+            LayerPaths::layer_iterator end,
+            size_t firstLayer = 0);
+    
+    /// streaming interface, for writing a gcode file while later layers 
+    /// are still being generated: call beginGcode once, writeLayer for each 
+    /// layer in order, then endGcode. The output is the same as that of 
+    /// writeGcodeFile, except that progress percentages count layers.
+    /// @param layerCount: how many layers will be written
+    /// @param firstLayer: number of the first layer written, for writing 
+    /// part of a print. Layers are numbered from it for extrusion 
+    /// profiles, fan and raft handling, and the anchor is only written 
+    /// when starting from layer 0.
+    void beginGcode(std::ostream& gout,
+            const std::string& title,
+            size_t layerCount,
+            size_t firstLayer = 0);
+    void writeLayer(std::ostream& gout,
+            LayerPaths& layerpaths,
+            LayerPaths::layer_iterator layer);
+    void endGcode(std::ostream& gout);
     
     /**
      @brief Calculate a profile given all parameters, and indicate if this 
@@ -226,12 +248,17 @@ void GCoder::writePath(std::ostream& ss,
     for (; current != path.end(); ++current) {
         Point2Type relative = (*current) - last;
 
-        std::stringstream comment;
-        Scalar distance = relative.magnitude();
-        comment << "d: " << distance;
+        const char* comment = NULL;
+        char distanceComment[32];
+        if (grueCfg.get_doMoveComments()) {
+            Scalar distance = relative.magnitude();
+            snprintf(distanceComment, sizeof(distanceComment), 
+                    "d: %g", distance);
+            comment = distanceComment;
+        }
         gantry.g1(ss, extruder, extrusion,
                 current->x, current->y, z,
-                extrusion.feedrate * feedScale, h, w, comment.str().c_str());
+                extrusion.feedrate * feedScale, h, w, comment);
         last = *current;
     }
 }
@@ -254,8 +281,9 @@ void GCoder::writePaths(std::ostream& ss,
             iter != labeledPaths.end();
             ++iter) {
         const LabeledOpenPath& currentLP = *iter;
-        writeProgressPercent(ss, progressCurrent+=currentLP.myPath.size(), 
-                progressTotal);
+        if(!progressByLayer)
+            writeProgressPercent(ss, 
+                    progressCurrent+=currentLP.myPath.size(), progressTotal);
         Extrusion extrusion;
         Scalar currentH = h;
         Scalar currentW = w;
@@ -269,7 +297,7 @@ void GCoder::writePaths(std::ostream& ss,
                     extrusion, currentLP.myPath, feedScale);
     }
     gantry.snort(ss, extruder, fluidstrusion);
-    ss << std::endl << std::endl;
+    ss << "\n\n";
 }
 
 template <typename PATH>
@@ -1,6 +1,7 @@
 #include "gcoder_gantry.h"
 #include "gcoder.h"
 #include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
@@ -240,6 +241,71 @@ void Gantry::snort(std::ostream &ss,
 	set_extruding(false);
 }
 
+/*
+ G1 lines make up nearly all of a gcode file, so they are formatted into a 
+ reused string and handed to the stream in one write, without flushing.
+ */
+
+void appendFixed(string& line, Scalar value, int precision) {
+	static const Scalar powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 
+			1e8, 1e9};
+	if (precision >= 0 && precision <= 9) {
+		Scalar scaled = fabs(value) * powers[precision];
+		// keep the product exact to well below the rounding threshold
+		if (scaled < 1e9) {
+			Scalar whole = floor(scaled);
+			Scalar fraction = scaled - whole;
+			// too close to a tie to trust the product, use the C library
+			if (fabs(fraction - 0.5) > 1e-6) {
+				unsigned long units = (unsigned long) whole + 
+						(fraction > 0.5 ? 1 : 0);
+				char digits[24];
+				char* end = digits + sizeof(digits);
+				char* cursor = end;
+				for (int i = 0; i < precision; ++i) {
+					*--cursor = '0' + units % 10;
+					units /= 10;
+				}
+				if (precision > 0)
+					*--cursor = '.';
+				do {
+					*--cursor = '0' + units % 10;
+					units /= 10;
+				} while (units);
+				if (copysign(1.0, value) < 0)
+					*--cursor = '-';
+				line.append(cursor, end - cursor);
+				return;
+			}
+		}
+	}
+	char digits[64];
+	int length = snprintf(digits, sizeof(digits), "%.*f", precision, value);
+	if (length < 0)
+		return;
+	if (size_t(length) < sizeof(digits)) {
+		line.append(digits, length);
+	} else {
+		// values near the top of the double range take hundreds of digits
+		size_t start = line.size();
+		line.resize(start + length + 1);
+		snprintf(&line[start], length + 1, "%.*f", precision, value);
+		line.resize(start + length);
+	}
+}
+
+/// Append @a value to @a line following the float format of @a ss.
+static void appendNumber(string& line, const ostream& ss, Scalar value) {
+	if ((ss.flags() & std::ios::floatfield) == std::ios::fixed) {
+		appendFixed(line, value, ss.precision());
+	} else {
+		char digits[64];
+		int length = snprintf(digits, sizeof(digits), "%.*g", 
+				int(ss.precision()), value);
+		line.append(digits, std::min<size_t>(length, sizeof(digits) - 1));
+	}
+}
+
 void Gantry::g1Motion(std::ostream &ss, Scalar mx, Scalar my, Scalar mz,
 		Scalar me, Scalar mfeed, Scalar /*h*/, Scalar /*w*/,
 		const char *g1Comment, bool doX,
@@ -273,15 +339,36 @@ void Gantry::g1Motion(std::ostream &ss, Scalar mx, Scalar my, Scalar mz,
 			(grueCfg.get_useEaxis() ? 'E' :
 			get_current_extruder_code());
 
-	ss << "G1";
-	if (doX) ss << " X" << mx;
-	if (doY) ss << " Y" << my;
-	if (doZ) ss << " Z" << mz;
-	if (doFeed) ss << " F" << mfeed;
-	if (doE) ss << " " << ss_axis << me;
-	if (g1Comment) ss << " " << grueCfg.get_commentOpen()
-                      << g1Comment << grueCfg.get_commentClose();
-	ss << endl;
+	gcodeLine.assign("G1");
+	if (doX) {
+		gcodeLine.append(" X");
+		appendNumber(gcodeLine, ss, mx);
+	}
+	if (doY) {
+		gcodeLine.append(" Y");
+		appendNumber(gcodeLine, ss, my);
+	}
+	if (doZ) {
+		gcodeLine.append(" Z");
+		appendNumber(gcodeLine, ss, mz);
+	}
+	if (doFeed) {
+		gcodeLine.append(" F");
+		appendNumber(gcodeLine, ss, mfeed);
+	}
+	if (doE) {
+		gcodeLine.push_back(' ');
+		gcodeLine.push_back(ss_axis);
+		appendNumber(gcodeLine, ss, me);
+	}
+	if (g1Comment && grueCfg.get_doMoveComments()) {
+		gcodeLine.push_back(' ');
+		gcodeLine.append(grueCfg.get_commentOpen());
+		gcodeLine.append(g1Comment);
+		gcodeLine.append(grueCfg.get_commentClose());
+	}
+	gcodeLine.push_back('\n');
+	ss.write(gcodeLine.data(), gcodeLine.size());
 
 	// if(feed >= 5000) assert(0);
 
@@ -9,6 +9,7 @@
 #define	GCODER_GANTRY_H
 
 #include "mgl.h"
+#include <string>
 
 namespace mgl{
 
@@ -188,8 +189,13 @@ private:
 	Scalar x,y,z,a,b,feed;     // current position and feed
 	unsigned char ab;
 	bool extruding;
+	std::string gcodeLine;	// reused to format g1 lines
 };
 
+/// Append @a value to @a line the way a stream in std::ios::fixed mode with 
+/// the given precision would print it.
+void appendFixed(std::string& line, Scalar value, int precision);
+
 }
 
 
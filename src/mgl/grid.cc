@@ -11,6 +11,7 @@
 
 #include <set>
 #include <map>
+#include <algorithm>
 
 #include "grid.h"
 #include "log.h"
@@ -25,7 +26,6 @@ using namespace std;
 
 
 const Scalar GRID_RANGE_TOL = 0.0;
-const Scalar GRID_CROSSING_COARSENESS = 0.0;
 
 ostream& operator <<(std::ostream &os, const ScalarRange &p) {
 	cout << "[" << p.min << ", " << p.max << "]";
@@ -60,18 +60,16 @@ void scalarRangesFromIntersections(const std::set<Scalar> &lineCuts, std::vector
 	}
 }
 
-void scalarRangesFromIntersections(std::vector<Scalar> &lineCuts, std::vector<ScalarRange> &ranges) {
-    std::sort(lineCuts.begin(), lineCuts.end());
-	ranges.reserve(lineCuts.size());
+/// Pairs up sorted crossings of one ray into inside ranges
+static void scalarRangesFromSortedCuts(const Scalar* cutBegin, 
+		const Scalar* cutEnd, std::vector<ScalarRange> &ranges) {
 	bool inside = false;
 	Scalar xBegin = 0; // initial value is not used
 	Scalar xEnd = 0; // initial value is not used
-	for (std::vector<Scalar>::iterator it = lineCuts.begin(); 
-            it != lineCuts.end(); ++it) {
+	for (const Scalar* it = cutBegin; it != cutEnd; ++it) {
 		Scalar intersection = *it;
 		if (inside) {
 			xEnd = intersection;
-			// gridSegments.push_back(LineSegment2(Point2Type(xBegin,y), Point2Type(xEnd,y)));
 			ranges.push_back(ScalarRange(xBegin, xEnd));
             inside = false;
 		} else {
@@ -87,6 +85,36 @@ void scalarRangesFromIntersections(std::vector<Scalar> &lineCuts, std::vector<Sc
 	}
 }
 
+void scalarRangesFromIntersections(std::vector<Scalar> &lineCuts, std::vector<ScalarRange> &ranges) {
+    std::sort(lineCuts.begin(), lineCuts.end());
+	if (lineCuts.empty())
+		return;
+	scalarRangesFromSortedCuts(&lineCuts[0], &lineCuts[0] + lineCuts.size(), 
+			ranges);
+}
+
+/**
+ Where a ray at v crosses the segment (au, av) - (bu, bv), measured along
+ the ray. A segment crosses the rays in [min(av, bv), max(av, bv)), so a
+ vertex sitting on a ray is counted once by exactly one of its segments
+ and horizontal segments are never counted.
+ */
+static inline bool rayCrossing(Scalar au, Scalar av, Scalar bu, Scalar bv, 
+		Scalar v, Scalar &u) {
+	if (av <= v) {
+		if (bv > v) {
+			Scalar t = (v - av) / (bv - av);
+			u = t * (bu - au) + au;
+			return true;
+		}
+	} else if (bv <= v) {
+		Scalar t = (v - bv) / (av - bv);
+		u = t * (au - bu) + bu;
+		return true;
+	}
+	return false;
+}
+
 void rayCastAlongX(const std::list<Loop>& outlineLoops,
 		Scalar y,
 		Scalar xMin,
@@ -105,25 +133,10 @@ void rayCastAlongX(const std::list<Loop>& outlineLoops,
 					iter != currentLoop.clockwiseEnd(); 
 					++iter) {
 				Segment2Type segment = currentLoop.segmentAfterPoint(iter);
-				Scalar intersectionX, intersectionY;
-                intersectionY = y;
-                if(segment.a.y < y + GRID_CROSSING_COARSENESS) {
-                    if(segment.b.y > y - GRID_CROSSING_COARSENESS) {
-                        Scalar t = (y - segment.a.y) / 
-                                (segment.b.y - segment.a.y);
-                        intersectionX = t * (segment.b.x - segment.a.x) + segment.a.x;
-                    } else {
-                        continue;
-                    }
-                } else if(segment.a.y > y - GRID_CROSSING_COARSENESS) {    // segment.a.y > y
-                    if(segment.b.y < y + GRID_CROSSING_COARSENESS) {
-                        Scalar t = (y - segment.b.y) / 
-                                (segment.a.y - segment.b.y);
-                        intersectionX = t * (segment.a.x - segment.b.x) + segment.b.x;
-                    } else {
-                        continue;
-                    }
-                }
+				Scalar intersectionX;
+				if (!rayCrossing(segment.a.x, segment.a.y, 
+						segment.b.x, segment.b.y, y, intersectionX))
+					continue;
 				if (intersectionX >= xMin && intersectionX < xMax) {
 					lineCuts.push_back(intersectionX);
 				}
@@ -150,25 +163,10 @@ void rayCastAlongY(const std::list<Loop>& outlineLoops,
 					it != currentLoop.clockwiseEnd(); 
 					it++) {
 				Segment2Type segment = currentLoop.segmentAfterPoint(it);
-				Scalar intersectionX, intersectionY;
-                intersectionX = x;
-                if(segment.a.x < x + GRID_CROSSING_COARSENESS) {
-                    if(segment.b.x > x - GRID_CROSSING_COARSENESS) {
-                        Scalar t = (x - segment.a.x) / 
-                                (segment.b.x - segment.a.x);
-                        intersectionY = t * (segment.b.y - segment.a.y) + segment.a.y;
-                    } else {
-                        continue;
-                    }
-                } else if(segment.a.x > x - GRID_CROSSING_COARSENESS) {    // segment.a.y > y
-                    if(segment.b.x < x + GRID_CROSSING_COARSENESS) {
-                        Scalar t = (x - segment.b.x) / 
-                                (segment.a.x - segment.b.x);
-                        intersectionY = t * (segment.a.y - segment.b.y) + segment.b.y;
-                    } else {
-                        continue;
-                    }
-                }
+				Scalar intersectionY;
+				if (!rayCrossing(segment.a.y, segment.a.x, 
+						segment.b.y, segment.b.x, x, intersectionY))
+					continue;
 				if (intersectionY >= yMin && intersectionY < yMax) {
 					lineCuts.push_back(intersectionY);
 				}
@@ -178,18 +176,157 @@ void rayCastAlongY(const std::list<Loop>& outlineLoops,
 	scalarRangesFromIntersections(lineCuts, ranges);
 }
 
+/// A loop segment in ray coordinates: u runs along the rays, v across 
+/// them. Rays [firstRay, endRay) are the ones the segment crosses.
+struct RayCastEdge {
+	Scalar au, av, bu, bv;
+	size_t firstRay, endRay;
+};
+
+/**
+ Casts every ray of a slice in one pass over the outlines. Each segment is
+ bucketed into the run of rays it spans (found by binary search in the
+ sorted ray values), crossings are written into a flat per-ray table and
+ each ray's crossings are sorted and paired. Cost is proportional to
+ segments + crossings instead of rays x segments. The crossings produced 
+ are the same values rayCastAlongX/Y compute one ray at a time.
+ Only every stride-th ray, starting with the first, is cast; the others 
+ are left empty.
+ */
+static void castRaysOnSlice(const std::list<Loop> &outlineLoops,
+		const std::vector<Scalar> &values,
+		Scalar min,
+		Scalar max,
+		bool alongX,
+		size_t stride,
+		ScalarRangeTable &rangeTable) {
+	assert(rangeTable.size() == 0);
+	size_t rayCount = values.size();
+	if (rayCount == 0)
+		return;
+
+	std::vector<RayCastEdge> edges;
+	// rays [spanBegin, spanEnd) are the ones crossing the outlines' bounds,
+	// the rest stay empty and get no bookkeeping
+	size_t spanBegin = rayCount;
+	size_t spanEnd = 0;
+	for (std::list<Loop>::const_iterator j = outlineLoops.begin(); 
+			j != outlineLoops.end(); 
+			++j) {
+		const Loop& currentLoop = *j;
+		if (currentLoop.empty())
+			continue;
+		for (Loop::const_finite_cw_iterator iter(currentLoop.clockwiseFinite()); 
+				iter != currentLoop.clockwiseEnd(); 
+				++iter) {
+			Segment2Type segment = currentLoop.segmentAfterPoint(iter);
+			RayCastEdge edge;
+			if (alongX) {
+				edge.au = segment.a.x; edge.av = segment.a.y;
+				edge.bu = segment.b.x; edge.bv = segment.b.y;
+			} else {
+				edge.au = segment.a.y; edge.av = segment.a.x;
+				edge.bu = segment.b.y; edge.bv = segment.b.x;
+			}
+			Scalar low = std::min(edge.av, edge.bv);
+			Scalar high = std::max(edge.av, edge.bv);
+			edge.firstRay = std::lower_bound(values.begin(), values.end(), 
+					low) - values.begin();
+			edge.endRay = std::lower_bound(values.begin() + edge.firstRay, 
+					values.end(), high) - values.begin();
+			// only rays that survive the stride matter
+			edge.firstRay = (edge.firstRay + stride - 1) / stride * stride;
+			if (edge.firstRay >= edge.endRay)
+				continue;
+			edges.push_back(edge);
+			spanBegin = std::min(spanBegin, edge.firstRay);
+			spanEnd = std::max(spanEnd, edge.endRay);
+		}
+	}
+	if (edges.empty()) {
+		rangeTable.resize(rayCount);
+		return;
+	}
+
+	// rayStart[i - spanBegin] counts crossings of ray i until turned into 
+	// offsets, skipped rays get no room
+	size_t spanCount = spanEnd - spanBegin;
+	std::vector<size_t> rayStart(spanCount + 1, 0);
+	for (std::vector<RayCastEdge>::const_iterator edge = edges.begin(); 
+			edge != edges.end(); ++edge) {
+		rayStart[edge->firstRay - spanBegin]++;
+		rayStart[edge->endRay - spanBegin]--;
+	}
+	size_t running = 0;
+	size_t offset = 0;
+	for (size_t i = 0; i < spanCount; i++) {
+		running += rayStart[i];
+		rayStart[i] = offset;
+		if ((spanBegin + i) % stride == 0)
+			offset += running;
+	}
+	rayStart[spanCount] = offset;
+	if (offset == 0) {
+		rangeTable.resize(rayCount);
+		return;
+	}
+
+	std::vector<Scalar> cuts(offset);
+	std::vector<size_t> rayEnd(rayStart.begin(), rayStart.end() - 1);
+	for (std::vector<RayCastEdge>::const_iterator edge = edges.begin(); 
+			edge != edges.end(); ++edge) {
+		for (size_t i = edge->firstRay; i < edge->endRay; i += stride) {
+			Scalar intersection;
+			if (!rayCrossing(edge->au, edge->av, edge->bu, edge->bv, 
+					values[i], intersection))
+				continue;
+			if (intersection >= min && intersection < max)
+				cuts[rayEnd[i - spanBegin]++] = intersection;
+		}
+	}
+	// every edge starts on a surviving ray, so spanBegin is one
+	rangeTable.reserveRanges(offset / 2);
+	rangeTable.resize(spanBegin);
+	std::vector<ScalarRange> ranges;
+	for (size_t i = spanBegin; i < spanEnd; i++) {
+		ranges.clear();
+		if (i % stride == 0) {
+			Scalar* cutBegin = &cuts[0] + rayStart[i - spanBegin];
+			Scalar* cutEnd = &cuts[0] + rayEnd[i - spanBegin];
+			std::sort(cutBegin, cutEnd);
+			scalarRangesFromSortedCuts(cutBegin, cutEnd, ranges);
+		}
+		rangeTable.push_back(ranges);
+	}
+	rangeTable.resize(rayCount);
+}
+
+static bool sortedValues(const std::vector<Scalar> &values) {
+	for (size_t i = 1; i < values.size(); i++) {
+		if (values[i] < values[i - 1])
+			return false;
+	}
+	return true;
+}
+
 void castRaysOnSliceAlongX(const std::list<Loop> &outlineLoops,
 		const std::vector<Scalar> &yValues,
 		Scalar xMin,
 		Scalar xMax,
-		ScalarRangeTable &rangeTable) {
+		ScalarRangeTable &rangeTable,
+		size_t stride) {
+	if (sortedValues(yValues)) {
+		castRaysOnSlice(outlineLoops, yValues, xMin, xMax, true, stride, 
+				rangeTable);
+		return;
+	}
 	assert(rangeTable.size() == 0);
-	rangeTable.resize(yValues.size());
-
-	for (size_t i = 0; i < rangeTable.size(); i++) {
-		Scalar y = yValues[i];
-		std::vector<ScalarRange> &ranges = rangeTable[i];
-		rayCastAlongX(outlineLoops, y, xMin, xMax, ranges);
+	std::vector<ScalarRange> ranges;
+	for (size_t i = 0; i < yValues.size(); i++) {
+		ranges.clear();
+		if (i % stride == 0)
+			rayCastAlongX(outlineLoops, yValues[i], xMin, xMax, ranges);
+		rangeTable.push_back(ranges);
 	}
 }
 
@@ -197,14 +334,20 @@ void castRaysOnSliceAlongY(const std::list<Loop> &outlineLoops,
 		const std::vector<Scalar> &values, // x
 		Scalar min,
 		Scalar max,
-		ScalarRangeTable &rangeTable) {
+		ScalarRangeTable &rangeTable,
+		size_t stride) {
+	if (sortedValues(values)) {
+		castRaysOnSlice(outlineLoops, values, min, max, false, stride, 
+				rangeTable);
+		return;
+	}
 	assert(rangeTable.size() == 0);
-	rangeTable.resize(values.size());
-
-	for (size_t i = 0; i < rangeTable.size(); i++) {
-		Scalar value = values[i];
-		std::vector<ScalarRange> &ranges = rangeTable[i];
-		rayCastAlongY(outlineLoops, value, min, max, ranges);
+	std::vector<ScalarRange> ranges;
+	for (size_t i = 0; i < values.size(); i++) {
+		ranges.clear();
+		if (i % stride == 0)
+			rayCastAlongY(outlineLoops, values[i], min, max, ranges);
+		rangeTable.push_back(ranges);
 	}
 }
 
@@ -233,14 +376,11 @@ void Grid::gridRangesToOpenPaths(const ScalarRangeTable &rays,
 								 const axis_e axis,
 								 OpenPathList &paths) const {
 
-	std::vector<Scalar>::const_iterator value = values.begin();
-	ScalarRangeTable::const_iterator ray = rays.begin();
-
-	for (;
-		 ray != rays.end() && value != values.end(); 
-		 ++value, ++ray) {
-		for (vector<ScalarRange>::const_iterator range = ray->begin();
-			 range != ray->end(); ++range) {
+	for (size_t i = 0; i < rays.size() && i < values.size(); ++i) {
+		ScalarRangeLine ray = rays[i];
+		const Scalar* value = &values[i];
+		for (ScalarRangeLine::const_iterator range = ray.begin();
+			 range != ray.end(); ++range) {
 			paths.push_back(OpenPath());
 
 			OpenPath &path = paths.back();
@@ -274,13 +414,13 @@ void pathsFromScalarRangesAlongAxis( const ScalarRangeTable &rays,	   // the ran
 	//Convert ray ranges to segments and map endpoints
 	vector<Point2Type> points;
 	for (size_t i = 0; i < rays.size(); i++) {
-		const vector<ScalarRange> &ray = rays[i];
+		ScalarRangeLine ray = rays[i];
 
 		if (ray.size() == 0) continue;
 
 		Scalar val = values[i];
 
-		for (vector<ScalarRange>::const_iterator j = ray.begin();
+		for (ScalarRangeLine::const_iterator j = ray.begin();
 				j != ray.end(); j++) {
 
 			assert(j->min != j->max);
@@ -371,10 +511,10 @@ bool intersectRange(Scalar a, Scalar b, Scalar c,
 	return true;
 }
 
-vector< ScalarRange >::const_iterator subRangeTersect(
+ScalarRangeLine::const_iterator subRangeTersect(
 		const ScalarRange &range,
-		vector< ScalarRange >::const_iterator it,
-		vector< ScalarRange >::const_iterator itEnd,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		vector< ScalarRange > &result) {
 
 	while (it != itEnd) {
@@ -395,16 +535,16 @@ vector< ScalarRange >::const_iterator subRangeTersect(
 	return it;
 }
 
-void rangeTersection(const vector< ScalarRange > &oneLine,
-		const vector< ScalarRange > &twoLine,
+void rangeTersection(const ScalarRangeLine &oneLine,
+		const ScalarRangeLine &twoLine,
 		vector< ScalarRange > &boolLine) {
 	//	static int toto = 0;
 	//	toto ++;
 	//	if(toto == 5007)
 	//		cout << toto << endl;
 
-	vector< ScalarRange >::const_iterator itOne = oneLine.begin();
-	vector< ScalarRange >::const_iterator itTwo = twoLine.begin();
+	ScalarRangeLine::const_iterator itOne = oneLine.begin();
+	ScalarRangeLine::const_iterator itTwo = twoLine.begin();
 	while (itOne != oneLine.end()) {
 		const ScalarRange &range = *itOne;
 		//Log::finest << string(" range=") << range << endl;
@@ -446,9 +586,9 @@ bool scalarRangeUnion(const ScalarRange& range0,
 // removes diffRange from srcRange. The result is put in resultRange, and srcRange is updated
 // returns false if there is no resultRange
 
-vector< ScalarRange >::const_iterator subRangeUnion(const ScalarRange &initialRange,
-		vector< ScalarRange >::const_iterator it,
-		vector< ScalarRange >::const_iterator itEnd,
+ScalarRangeLine::const_iterator subRangeUnion(const ScalarRange &initialRange,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		vector< ScalarRange > &result) {
 
 	ScalarRange range(initialRange);
@@ -484,15 +624,15 @@ vector< ScalarRange >::const_iterator subRangeUnion(const ScalarRange &initialRa
 	return it;
 }
 
-void rangeUnion(const vector< ScalarRange > &firstLine,
-		const vector< ScalarRange > &secondLine,
+void rangeUnion(const ScalarRangeLine &firstLine,
+		const ScalarRangeLine &secondLine,
 		vector< ScalarRange > &unionLine) {
-	vector< ScalarRange >::const_iterator itOne = firstLine.begin();
-	vector< ScalarRange >::const_iterator itTwo = secondLine.begin();
+	ScalarRangeLine::const_iterator itOne = firstLine.begin();
+	ScalarRangeLine::const_iterator itTwo = secondLine.begin();
 
 	// the first line is empty... return the second one
 	if (itOne == firstLine.end()) {
-		unionLine = secondLine;
+		unionLine.assign(secondLine.begin(), secondLine.end());
 		return;
 	}
 
@@ -585,10 +725,10 @@ bool scalarRangeDifference(const ScalarRange& diffRange,
 	return false;
 }
 
-vector< ScalarRange >::const_iterator subRangeDifference(
+ScalarRangeLine::const_iterator subRangeDifference(
 		const ScalarRange &initialRange,
-		vector< ScalarRange >::const_iterator it,
-		vector< ScalarRange >::const_iterator itEnd,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		vector< ScalarRange > &result) {
 	ScalarRange range(initialRange);
 	// cout << "subRangeDifference from " << range << endl;
@@ -623,11 +763,11 @@ vector< ScalarRange >::const_iterator subRangeDifference(
 	return it;
 }
 
-void rangeDifference(const vector< ScalarRange > &srcLine,
-		const vector< ScalarRange > &delLine,
+void rangeDifference(const ScalarRangeLine &srcLine,
+		const ScalarRangeLine &delLine,
 		vector< ScalarRange > &diffLine) {
-	vector< ScalarRange >::const_iterator itOne = srcLine.begin();
-	vector< ScalarRange >::const_iterator itTwo = delLine.begin();
+	ScalarRangeLine::const_iterator itOne = srcLine.begin();
+	ScalarRangeLine::const_iterator itTwo = delLine.begin();
 	while (itOne != srcLine.end()) {
 		const ScalarRange &range = *itOne;
 		// cout << "src_range =" << range << endl;
@@ -656,14 +796,13 @@ void rangeTableDifference(const ScalarRangeTable &src,
 		size_t delSize = del.size();
 		assert(lineCount == delSize);
 	}
-	diff.resize(lineCount);
+	diff.clear();
 
+	vector<ScalarRange> lineRangeDiff;
 	for (size_t i = 0; i < src.size(); i++) {
-		const vector<ScalarRange> &lineRangeSrc = src[i];
-		const vector<ScalarRange> &lineRangeDel = del[i];
-		vector<ScalarRange> &lineRangeDiff = diff[i];
-
-		rangeDifference(lineRangeSrc, lineRangeDel, lineRangeDiff);
+		lineRangeDiff.clear();
+		rangeDifference(src[i], del[i], lineRangeDiff);
+		diff.push_back(lineRangeDiff);
 	}
 
 
@@ -684,14 +823,14 @@ void rangeTableIntersection(const ScalarRangeTable &a,
 	}
 	
 	assert(lineCount == b.size());
-	result.resize(lineCount);
+	result.clear();
 
+	vector<ScalarRange> lineRangeRes;
 	for (size_t i = 0; i < lineCount; i++) {
-		const vector<ScalarRange> &lineRange0 = a[i];
-		const vector<ScalarRange> &lineRange1 = b[i];
-		vector<ScalarRange> &lineRangeRes = result[i];
+		lineRangeRes.clear();
 		// cout << "rangeTableIntersection " << i << endl;
-		rangeTersection(lineRange0, lineRange1, lineRangeRes);
+		rangeTersection(a[i], b[i], lineRangeRes);
+		result.push_back(lineRangeRes);
 	}
 }
 
@@ -711,16 +850,13 @@ void rangeTableUnion(const ScalarRangeTable &a,
 	}
 
 	assert(lineCount == b.size());
-	result.resize(lineCount);
+	result.clear();
 
+	vector<ScalarRange> lineRangeRes;
 	for (size_t i = 0; i < a.size(); i++) {
-		const vector<ScalarRange> &lineRange0 = a[i];
-		const vector<ScalarRange> &lineRange1 = b[i];
-		vector<ScalarRange> &lineRangeRes = result[i];
-		if (lineRangeRes.size() > 0) {
-			assert(0);
-		}
-		rangeUnion(lineRange0, lineRange1, lineRangeRes);
+		lineRangeRes.clear();
+		rangeUnion(a[i], b[i], lineRangeRes);
+		result.push_back(lineRangeRes);
 	}
 }
 
@@ -780,23 +916,38 @@ void Grid::createGridRanges(const std::list<Loop>& loops,
 	castRaysOnSliceAlongY(loops, xValues, yMin, yMax, outGridRanges.yRays);
 }
 
+void Grid::createGridRanges(const std::list<Loop>& loops, 
+		axis_e axis, 
+		size_t skipCount, 
+		GridRanges& outGridRanges) const {
+	assert(axis == X_AXIS || axis == Y_AXIS);
+	if (axis == X_AXIS) {
+		castRaysOnSliceAlongX(loops, yValues, xValues[0], xValues.back(), 
+				outGridRanges.xRays, skipCount + 1);
+		outGridRanges.yRays.resize(xValues.size());
+	} else {
+		outGridRanges.xRays.resize(yValues.size());
+		castRaysOnSliceAlongY(loops, xValues, yValues[0], yValues.back(), 
+				outGridRanges.yRays, skipCount + 1);
+	}
+}
+
 void Grid::subSample(const GridRanges &gridRanges, 
 		size_t skipCount, 
 		GridRanges &result) const {
 	assert(result.xRays.size() == 0);
 	assert(result.yRays.size() == 0);
 
-	result.xRays.resize(gridRanges.xRays.size());
-	result.yRays.resize(gridRanges.yRays.size());
-
+	// deep copy of the ranges for the selected lines, skipping lines 
+	// depending on selected infill density
 	for (size_t i = 0; i < gridRanges.xRays.size(); i++) {
-		result.xRays[i] = gridRanges.xRays[i]; // deep copy of the ranges for the selected lines
-		i += skipCount; // skip lines depending on selected infill density
+		result.xRays.push_back(i % (skipCount + 1) == 0 ? 
+				gridRanges.xRays[i] : ScalarRangeLine());
 	}
 
 	for (size_t i = 0; i < gridRanges.yRays.size(); i++) {
-		result.yRays[i] = gridRanges.yRays[i]; // deep copy of the ranges for the selected lines
-		i += skipCount; // skip lines depending on selected infill density
+		result.yRays.push_back(i % (skipCount + 1) == 0 ? 
+				gridRanges.yRays[i] : ScalarRangeLine());
 	}
 }
 
@@ -839,7 +990,7 @@ void Grid::gridRangeIntersection(const GridRanges& a,
 	rangeTableIntersection(a.yRays, b.yRays, result.yRays);
 }
 
-void rangeTrim(const vector<ScalarRange> &src, 
+void rangeTrim(const ScalarRangeLine &src, 
 		Scalar cutOff, vector<ScalarRange> &result) {
 	assert(result.size() == 0);
 	// cout << "rangeTrim" << endl;
@@ -859,19 +1010,18 @@ void rangeTableTrim(const ScalarRangeTable &src,
 		ScalarRangeTable &result) {
 	//cout << "rangeTableTrim" << endl;
 	assert(result.size() == 0);
-	result.resize(src.size());
+	vector<ScalarRange> lineTrims;
 	for (size_t i = 0; i < src.size(); i++) {
-		const vector<ScalarRange> &lineSrc = src[i];
-		vector<ScalarRange> &lineTrims = result[i];
-		rangeTrim(lineSrc, cutOff, lineTrims);
+		lineTrims.clear();
+		rangeTrim(src[i], cutOff, lineTrims);
+		result.push_back(lineTrims);
 	}
 }
 
 void dumpRangeTable(const ScalarRangeTable &table) {
 	cout << "Rays " << table.size() << ":";
-	for (ScalarRangeTable::const_iterator ranges = table.begin();
-		 ranges != table.end(); ranges++) {
-		cout << ranges->size() << ", ";
+	for (size_t i = 0; i < table.size(); i++) {
+		cout << table[i].size() << ", ";
 	}
 
 	cout << endl;
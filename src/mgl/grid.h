@@ -47,7 +47,69 @@ public:
 
 std::ostream& operator << (std::ostream &os, const ScalarRange &pt);
 
-typedef std::vector<std::vector<ScalarRange> > ScalarRangeTable;
+/// Read only view of the ranges of one ray, sorted along the ray. It is
+/// invalidated by changes to the table or vector it looks into.
+class ScalarRangeLine {
+public:
+	typedef const ScalarRange* const_iterator;
+	ScalarRangeLine() : first(NULL), last(NULL) {}
+	ScalarRangeLine(const_iterator begin, const_iterator end) 
+			: first(begin), last(end) {}
+	ScalarRangeLine(const std::vector<ScalarRange>& ranges) 
+			: first(ranges.empty() ? NULL : &ranges[0]), 
+			last(first + ranges.size()) {}
+	const_iterator begin() const { return first; }
+	const_iterator end() const { return last; }
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+	const ScalarRange& operator[](size_t i) const { return first[i]; }
+	const ScalarRange& front() const { return *first; }
+	const ScalarRange& back() const { return *(last - 1); }
+private:
+	const_iterator first;
+	const_iterator last;
+};
+
+/**
+ The ranges of a set of parallel rays, one row per ray. All ranges are 
+ kept back to back in one array, with the offset of each ray's first 
+ range, so a table costs two allocations however many rays it has. Rows
+ are only added at the end.
+ */
+class ScalarRangeTable {
+public:
+	/// number of rays
+	size_t size() const { return offsets.size(); }
+	bool empty() const { return offsets.empty(); }
+	/// number of ranges over all rays
+	size_t rangeCount() const { return ranges.size(); }
+	ScalarRangeLine operator[](size_t ray) const {
+		const ScalarRange* base = ranges.empty() ? NULL : &ranges[0];
+		size_t end = ray + 1 < offsets.size() ? 
+				offsets[ray + 1] : ranges.size();
+		return ScalarRangeLine(base + offsets[ray], base + end);
+	}
+	/// add a ray holding a copy of @a line
+	void push_back(const ScalarRangeLine& line) {
+		offsets.push_back(ranges.size());
+		ranges.insert(ranges.end(), line.begin(), line.end());
+	}
+	/// add empty rays, or drop rays from the end, to hold @a rayCount rays
+	void resize(size_t rayCount) {
+		if (rayCount < offsets.size())
+			ranges.resize(offsets[rayCount]);
+		offsets.resize(rayCount, ranges.size());
+	}
+	void reserveRanges(size_t rangeCount) { ranges.reserve(rangeCount); }
+	void clear() { offsets.clear(); ranges.clear(); }
+	void swap(ScalarRangeTable& other) {
+		offsets.swap(other.offsets);
+		ranges.swap(other.ranges);
+	}
+private:
+	std::vector<size_t> offsets;
+	std::vector<ScalarRange> ranges;
+};
 
 
 class GridRanges {
@@ -55,16 +117,10 @@ public:
     ScalarRangeTable xRays;
     ScalarRangeTable yRays;
 	size_t xRaysCount() const {
-		size_t accum = 0;
-		for(size_t i=0; i<xRays.size(); ++i)
-			accum+=xRays[i].size();
-		return accum;
+		return xRays.rangeCount();
 	}
 	size_t yRaysCount() const {
-		size_t accum = 0;
-		for(size_t i=0; i<yRays.size(); ++i)
-			accum+=yRays[i].size();
-		return accum;
+		return yRays.rangeCount();
 	}
 	size_t raysCount() const {
 		return xRaysCount() + yRaysCount();
@@ -73,34 +129,34 @@ public:
 
 bool intersectRange(Scalar a, Scalar b, Scalar c, 
 		Scalar d, Scalar &begin, Scalar &end);
-std::vector< ScalarRange >::const_iterator  subRangeTersect( 
+ScalarRangeLine::const_iterator subRangeTersect( 
 		const ScalarRange &range,
-		std::vector< ScalarRange >::const_iterator it,
-		std::vector< ScalarRange >::const_iterator itEnd,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		std::vector< ScalarRange > &result );
-void rangeTersection(const std::vector< ScalarRange > &oneLine,
-		const std::vector< ScalarRange > &twoLine,
+void rangeTersection(const ScalarRangeLine &oneLine,
+		const ScalarRangeLine &twoLine,
 		std::vector< ScalarRange > &boolLine );
 bool scalarRangeUnion(const ScalarRange& range0, 
 		const ScalarRange& range1, ScalarRange &resultRange);
-std::vector< ScalarRange >::const_iterator  subRangeUnion(
+ScalarRangeLine::const_iterator subRangeUnion(
 		const ScalarRange &initialRange,
-		std::vector< ScalarRange >::const_iterator it,
-		std::vector< ScalarRange >::const_iterator itEnd,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		std::vector< ScalarRange > &result );
-void rangeUnion( const std::vector< ScalarRange > &firstLine,
-		const std::vector< ScalarRange > &secondLine,
+void rangeUnion( const ScalarRangeLine &firstLine,
+		const ScalarRangeLine &secondLine,
 		std::vector< ScalarRange > &unionLine );
 bool scalarRangeDifference(const ScalarRange& diffRange,
 		ScalarRange& srcRange,
 		ScalarRange &resultRange);
-std::vector< ScalarRange >::const_iterator  subRangeDifference(
+ScalarRangeLine::const_iterator subRangeDifference(
 		const ScalarRange &initialRange,
-		std::vector< ScalarRange >::const_iterator it,
-		std::vector< ScalarRange >::const_iterator itEnd,
+		ScalarRangeLine::const_iterator it,
+		ScalarRangeLine::const_iterator itEnd,
 		std::vector< ScalarRange > &result );
-void rangeDifference(const std::vector< ScalarRange > &srcLine,
-		const std::vector< ScalarRange > &delLine,
+void rangeDifference(const ScalarRangeLine &srcLine,
+		const ScalarRangeLine &delLine,
 		std::vector< ScalarRange > &diffLine );
 void rangeTableDifference(const ScalarRangeTable &src,
 		const ScalarRangeTable &del,
@@ -121,16 +177,20 @@ void rayCastAlongY(const std::list<Loop>& outlineLoops,
 		Scalar yMin,
 		Scalar yMax,
 		std::vector<ScalarRange> &ranges);
+/// cast one ray per value, or with @a stride only every stride-th one
+/// starting with the first, leaving the rays in between empty
 void castRaysOnSliceAlongX(const std::list<Loop>& outlineLoops,
 		const std::vector<Scalar> &yValues,
 		Scalar xMin,
 		Scalar xMax,
-		ScalarRangeTable &rangeTable);
+		ScalarRangeTable &rangeTable,
+		size_t stride = 1);
 void castRaysOnSliceAlongY(const std::list<Loop>& outlineLoops,
 		const std::vector<Scalar> &values, // x
 		Scalar min,
 		Scalar max,
-		ScalarRangeTable &rangeTable);
+		ScalarRangeTable &rangeTable,
+		size_t stride = 1);
 bool crossesOutline(const Segment2Type &seg,
 		const SegmentTable &outline);
 
@@ -172,6 +232,15 @@ public:
 	void createGridRanges(const std::list<Loop>& loops, 
 			GridRanges& outGridRanges) const;
 
+    /// Same as above followed by subSample, but only casts the rays that
+    /// survive: those along @a axis, and of them only every
+    /// (skipCount + 1)th line. Rays of the other axis are left empty.
+    /// Use it when only one direction of the ranges will be read.
+	void createGridRanges(const std::list<Loop>& loops, 
+			axis_e axis, 
+			size_t skipCount, 
+			GridRanges& outGridRanges) const;
+
     /// The grid starts out at 100% infill, this function selectlviy removes filament
     /// based on a skip count to reduce density
     /// @param srcGridRanges: input grid range to sub-sample
@@ -24,21 +24,41 @@ void LoopProcessor::processLoops(const LayerLoops& input, LayerLoops& output) {
     for(LayerLoops::const_layer_iterator layerIter = input.begin(); 
             layerIter != input.end(); 
             ++layerIter) {
-        const LayerLoops::Layer& currentInputLayer = *layerIter; 
-        LayerLoops::Layer currentOutputLayer(currentInputLayer.getIndex());
-        for(LayerLoops::const_loop_iterator loopIter = currentInputLayer.begin(); 
-                loopIter != currentInputLayer.end(); 
-                ++loopIter) {
-            Loop processed;
-            smooth(*loopIter, grueCfg.get_preCoarseness(), processed, 
-                    grueCfg.get_directionWeight());
-            currentOutputLayer.push_back(processed);
-        }
-        
-        output.push_back(currentOutputLayer);
+        LayerLoops::layer_iterator outputLayer = output.insert(output.end(), 
+                LayerLoops::Layer(layerIter->getIndex()));
+        processLayer(*layerIter, *outputLayer);
         tick();
     }
 }
 
+void LoopProcessor::consumeLoops(LayerLoops& input, LayerLoops& output) {
+    if(&input == &output) {
+        //to prevent problems writing to the thing on which we work
+        throw Exception("Loop Processor attempted to do in-place processing");
+    }
+    output.layerMeasure = input.layerMeasure;
+    initProgress("Loop Processing", input.size());
+    
+    while(!input.empty()) {
+        LayerLoops::layer_iterator outputLayer = output.insert(output.end(), 
+                LayerLoops::Layer(input.begin()->getIndex()));
+        processLayer(*input.begin(), *outputLayer);
+        input.pop_front();
+        tick();
+    }
+}
+
+void LoopProcessor::processLayer(const LayerLoops::Layer& input, 
+        LayerLoops::Layer& output) {
+    for(LayerLoops::const_loop_iterator loopIter = input.begin(); 
+            loopIter != input.end(); 
+            ++loopIter) {
+        LayerLoops::loop_iterator processed = output.insert(output.end(), 
+                Loop());
+        smooth(*loopIter, grueCfg.get_preCoarseness(), *processed, 
+                grueCfg.get_directionWeight());
+    }
+}
+
 }
 
@@ -21,10 +21,15 @@ public:
     LoopProcessor(const GrueConfig& grueConf, ProgressBar* progress = NULL) 
             : Progressive(progress), grueCfg(grueConf) {}
     void processLoops(const LayerLoops& input, LayerLoops& output);
+    /// Like processLoops, but frees each layer of @a input as soon as it 
+    /// is processed, leaving @a input empty.
+    void consumeLoops(LayerLoops& input, LayerLoops& output);
+    /// Process the loops of a single layer, appending them to @a output. 
+    /// Layers do not depend on each other, so they can be processed as 
+    /// they are sliced.
+    void processLayer(const LayerLoops::Layer& input, 
+            LayerLoops::Layer& output);
 private:
-    
-
-    
     const GrueConfig& grueCfg;
 };
 
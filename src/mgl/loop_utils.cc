@@ -72,25 +72,209 @@ void ClPolygonToLoop(const ClipperLib::Polygons &clpolys,
 }
 
 
-void runClipper(LoopList &dest, const LoopList &subject, const LoopList &apply,
+ClipperRegion::ClipperRegion(const LoopList& loops) {
+	loopToClPolygon(loops, m_polygons);
+}
+
+void ClipperRegion::toLoops(LoopList& loops) const {
+	ClPolygonToLoop(m_polygons, loops);
+}
+
+
+void runClipper(ClipperLib::Polygons &dest, 
+				const ClipperLib::Polygons &subject, 
+				const ClipperLib::Polygons &apply,
 				const ClipperLib::ClipType type) {
 	ClipperLib::Clipper clip;
 
-	ClipperLib::Polygons clsubject;
-	loopToClPolygon(subject, clsubject);
-	clip.AddPolygons(clsubject, ClipperLib::ptSubject);
-	
-	ClipperLib::Polygons clapply;
-	loopToClPolygon(apply, clapply);
-	clip.AddPolygons(clapply, ClipperLib::ptClip);
+	clip.AddPolygons(subject, ClipperLib::ptSubject);
+	clip.AddPolygons(apply, ClipperLib::ptClip);
 
-	ClipperLib::Polygons cldest;
-	clip.Execute(type, cldest);
+	clip.Execute(type, dest);
+}
 
-	ClPolygonToLoop(cldest, dest);
+void runClipper(LoopList &dest, const LoopList &subject, const LoopList &apply,
+				const ClipperLib::ClipType type) {
+	ClipperRegion cldest;
+	runClipper(cldest.polygons(), ClipperRegion(subject).polygons(), 
+			   ClipperRegion(apply).polygons(), type);
+	cldest.toLoops(dest);
 }	
 
 
+void regionsUnion(ClipperRegion &dest,
+				  const ClipperRegion &subject, const ClipperRegion &apply) {
+	runClipper(dest.polygons(), subject.polygons(), apply.polygons(), 
+			   ClipperLib::ctUnion);
+}
+
+void regionsUnion(ClipperRegion &subject, const ClipperRegion &apply) {
+	regionsUnion(subject, subject, apply);
+}
+
+void regionsUnion(ClipperRegion &dest, 
+				  const std::vector<const ClipperRegion*> &operands) {
+	ClipperLib::Clipper clip;
+	for (std::vector<const ClipperRegion*>::const_iterator operand = 
+			operands.begin(); operand != operands.end(); ++operand) {
+		clip.AddPolygons((*operand)->polygons(), ClipperLib::ptSubject);
+	}
+	//even-odd filling would cancel out where operands overlap
+	clip.Execute(ClipperLib::ctUnion, dest.polygons(), 
+				 ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+}
+
+RegionWindowUnion::RegionWindowUnion(
+		const std::vector<const ClipperRegion*> &regions, 
+		size_t before, size_t after) 
+		: m_before(before), m_after(after), m_block(before + after + 1), 
+		m_heads(regions.size()), m_tails(regions.size()) {
+	for (size_t start = 0; start < regions.size(); start += m_block) {
+		size_t end = std::min(start + m_block, regions.size());
+		m_heads[start] = *regions[start];
+		for (size_t i = start + 1; i < end; ++i)
+			regionsUnion(m_heads[i], m_heads[i - 1], *regions[i]);
+		m_tails[end - 1] = *regions[end - 1];
+		for (size_t i = end - 1; i-- > start;)
+			regionsUnion(m_tails[i], *regions[i], m_tails[i + 1]);
+	}
+}
+
+void RegionWindowUnion::pieces(size_t index, 
+		std::vector<const ClipperRegion*> &out) const {
+	size_t first = index < m_before ? 0 : index - m_before;
+	size_t last = std::min(index + m_after, m_heads.size() - 1);
+	size_t firstBlock = first / m_block;
+	size_t lastBlock = last / m_block;
+	if (firstBlock != lastBlock) {
+		out.push_back(&m_tails[first]);
+		out.push_back(&m_heads[last]);
+	} else if (first == firstBlock * m_block) {
+		//a window cut short by the start of the sequence
+		out.push_back(&m_heads[last]);
+	} else {
+		//a window cut short by the end of the sequence
+		out.push_back(&m_tails[first]);
+	}
+}
+
+void regionsDifference(ClipperRegion &dest,
+					   const ClipperRegion &subject, const ClipperRegion &apply) {
+	runClipper(dest.polygons(), subject.polygons(), apply.polygons(), 
+			   ClipperLib::ctDifference);
+}
+
+void regionsDifference(ClipperRegion &subject, const ClipperRegion &apply) {
+	regionsDifference(subject, subject, apply);
+}
+
+void regionsIntersection(ClipperRegion &dest,
+						 const ClipperRegion &subject, const ClipperRegion &apply) {
+	runClipper(dest.polygons(), subject.polygons(), apply.polygons(), 
+			   ClipperLib::ctIntersection);
+}
+
+void regionsIntersection(ClipperRegion &subject, const ClipperRegion &apply) {
+	regionsIntersection(subject, subject, apply);
+}
+
+void regionsOffset(ClipperRegion& dest, const ClipperRegion& subject, 
+				   Scalar distance, bool square) {
+	ClipperLib::OffsetPolygons(subject.polygons(), dest.polygons(), 
+							   distance * DBLTOINT, 
+							   square ? ClipperLib::jtSquare
+							   :ClipperLib::jtMiter, 2.0);
+}
+
+/// squared distance from @a point to the segment from @a a to @a b
+static double squaredSegmentDistance(const ClipperLib::IntPoint& point,
+		const ClipperLib::IntPoint& a, const ClipperLib::IntPoint& b) {
+	double dx = double(b.X - a.X);
+	double dy = double(b.Y - a.Y);
+	double px = double(point.X - a.X);
+	double py = double(point.Y - a.Y);
+	double length = dx * dx + dy * dy;
+	double t = length > 0 ? (px * dx + py * dy) / length : 0;
+	t = std::max(0.0, std::min(1.0, t));
+	px -= t * dx;
+	py -= t * dy;
+	return px * px + py * py;
+}
+
+/**
+ @brief mark in @a keep the vertices Douglas-Peucker keeps on the chain
+ of @a polygon from @a first forward to @a last, both already kept.
+ @a last may run past the end of @a polygon, indices wrap around.
+ */
+static void simplifyChain(const ClipperLib::Polygon& polygon,
+		size_t first, size_t last, double squaredTolerance,
+		std::vector<bool>& keep) {
+	size_t count = polygon.size();
+	std::vector<std::pair<size_t, size_t> > chains;
+	chains.push_back(std::make_pair(first, last));
+	while (!chains.empty()) {
+		std::pair<size_t, size_t> chain = chains.back();
+		chains.pop_back();
+		const ClipperLib::IntPoint& a = polygon[chain.first % count];
+		const ClipperLib::IntPoint& b = polygon[chain.second % count];
+		double farthest = squaredTolerance;
+		size_t split = chain.first;
+		for (size_t i = chain.first + 1; i < chain.second; ++i) {
+			double distance = squaredSegmentDistance(polygon[i % count], a, b);
+			if (distance > farthest) {
+				farthest = distance;
+				split = i;
+			}
+		}
+		if (split == chain.first)
+			continue;
+		keep[split % count] = true;
+		chains.push_back(std::make_pair(chain.first, split));
+		chains.push_back(std::make_pair(split, chain.second));
+	}
+}
+
+void regionsSimplify(ClipperRegion& dest, const ClipperRegion& subject,
+					 Scalar tolerance) {
+	double squaredTolerance = tolerance * DBLTOINT * tolerance * DBLTOINT;
+	ClipperLib::Polygons simplified;
+	simplified.reserve(subject.polygons().size());
+	std::vector<bool> keep;
+	for (ClipperLib::Polygons::const_iterator polygon =
+			subject.polygons().begin();
+			polygon != subject.polygons().end(); ++polygon) {
+		size_t count = polygon->size();
+		if (count < 3)
+			continue;
+		//anchor on the first vertex and the one farthest from it
+		size_t opposite = 0;
+		double farthest = 0;
+		for (size_t i = 1; i < count; ++i) {
+			double dx = double((*polygon)[i].X - (*polygon)[0].X);
+			double dy = double((*polygon)[i].Y - (*polygon)[0].Y);
+			if (dx * dx + dy * dy > farthest) {
+				farthest = dx * dx + dy * dy;
+				opposite = i;
+			}
+		}
+		keep.assign(count, false);
+		keep[0] = true;
+		keep[opposite] = true;
+		simplifyChain(*polygon, 0, opposite, squaredTolerance, keep);
+		simplifyChain(*polygon, opposite, count, squaredTolerance, keep);
+		simplified.push_back(ClipperLib::Polygon());
+		ClipperLib::Polygon& result = simplified.back();
+		for (size_t i = 0; i < count; ++i) {
+			if (keep[i])
+				result.push_back((*polygon)[i]);
+		}
+		if (result.size() < 3)
+			simplified.pop_back();
+	}
+	dest.polygons().swap(simplified);
+}
+
+
 void loopsUnion(LoopList &dest,
 				const LoopList &subject, const LoopList &apply) {
 	runClipper(dest, subject, apply, ClipperLib::ctUnion);
@@ -132,13 +316,9 @@ void loopsXOR(LoopList &subject, const LoopList &apply) {
 
 void loopsOffset(LoopList& dest, const LoopList& subject, Scalar distance,
 				 bool square) {
-	ClipperLib::Polygons subjectPolys, destPolys;
-	loopToClPolygon(subject, subjectPolys);
-	ClipperLib::OffsetPolygons(subjectPolys, destPolys, distance * DBLTOINT, 
-							   square ? ClipperLib::jtSquare
-							   :ClipperLib::jtMiter, 2.0);
-
-	ClPolygonToLoop(destPolys, dest);
+	ClipperRegion destRegion;
+	regionsOffset(destRegion, ClipperRegion(subject), distance, square);
+	destRegion.toLoops(dest);
 }
 
 enum SMOOTH_RESULT {
@@ -3,7 +3,9 @@
 
 #include "loop_path.h"
 #include "labeled_path.h"
+#include "clipper.h"
 #include <set>
+#include <vector>
 
 namespace mgl {
 
@@ -109,6 +111,89 @@ Loop createConvexLoop(const COLLECTION<Loop, ALLOC>& input){
 	return retLoop;
 }
 
+/**
+ @brief An area kept in the integer coordinates of the clipping library.
+ Chaining the regions* operations below on these skips the conversion 
+ to and from LoopList that every loops* operation pays. Convert with 
+ toLoops only where loops are actually needed.
+ */
+class ClipperRegion {
+public:
+	ClipperRegion() {}
+	explicit ClipperRegion(const LoopList& loops);
+	/// replace @a loops with the loops of this region
+	void toLoops(LoopList& loops) const;
+	bool empty() const { return m_polygons.empty(); }
+	void clear() { m_polygons.clear(); }
+	void swap(ClipperRegion& other) { m_polygons.swap(other.m_polygons); }
+	ClipperLib::Polygons& polygons() { return m_polygons; }
+	const ClipperLib::Polygons& polygons() const { return m_polygons; }
+private:
+	ClipperLib::Polygons m_polygons;
+};
+
+void regionsUnion(ClipperRegion &subject, const ClipperRegion &apply);
+void regionsUnion(ClipperRegion &dest,
+				  const ClipperRegion &subject, const ClipperRegion &apply);
+
+/**
+ @brief union of all @a operands in a single pass of the clipping library
+ Operands must be results of other regions* operations, so their outer 
+ boundaries and holes are consistently oriented.
+ */
+void regionsUnion(ClipperRegion &dest, 
+				  const std::vector<const ClipperRegion*> &operands);
+
+/**
+ @brief Unions over a window sliding along a sequence of regions.
+ The sequence is cut into blocks as long as the window, and running 
+ unions are kept from each block start forward and from each block end 
+ backward. Every window is then covered by at most two of those, the 
+ tail of one block and the head of the next, no matter how long the 
+ window is. Building costs two binary unions per region.
+ */
+class RegionWindowUnion {
+public:
+	/**
+	 @param regions the sequence, must outlive this object
+	 @param before how many regions before an index its window reaches
+	 @param after how many regions after an index its window reaches
+	 */
+	RegionWindowUnion(const std::vector<const ClipperRegion*> &regions, 
+					  size_t before, size_t after);
+	/// append the pieces whose union is the window around @a index
+	void pieces(size_t index, std::vector<const ClipperRegion*> &out) const;
+private:
+	size_t m_before;
+	size_t m_after;
+	size_t m_block;
+	/// union from the start of the block up to each index
+	std::vector<ClipperRegion> m_heads;
+	/// union from each index up to the end of the block
+	std::vector<ClipperRegion> m_tails;
+};
+
+void regionsDifference(ClipperRegion &subject, const ClipperRegion &apply);
+void regionsDifference(ClipperRegion &dest,
+					   const ClipperRegion &subject, const ClipperRegion &apply);
+
+void regionsIntersection(ClipperRegion &subject, const ClipperRegion &apply);
+void regionsIntersection(ClipperRegion &dest,
+						 const ClipperRegion &subject, const ClipperRegion &apply);
+
+void regionsOffset(ClipperRegion& dest, const ClipperRegion& subject, 
+				   Scalar distance, bool square = true);
+
+/**
+ @brief @a subject without the vertices that stay within @a tolerance
+ of the outline left when they are dropped (Douglas-Peucker).
+ Polygons that collapse are dropped too. Edges may cross where the
+ region is thinner than @a tolerance, so pass the result through
+ another regions* operation before converting it to loops.
+ */
+void regionsSimplify(ClipperRegion& dest, const ClipperRegion& subject,
+					 Scalar tolerance);
+
 void loopsUnion(LoopList &subject, const LoopList &apply);
 void loopsUnion(LoopList &dest,
 				const LoopList &subject, const LoopList &apply);
@@ -9,6 +9,18 @@
 #include <cstring>
 #include <list>
 #include <sstream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "log.h"
 
@@ -183,170 +195,448 @@ void Meshy::writeStlFile(const char* fileName) const {
 //	// Log::often() << fileName << " written!"<< std::endl;
 //}
 
-/// Loads an STL file into a mesh object, from a binary or ASCII stl file.
-///
-/// @param stlFilename target file to load into the specified mesh
-///
-/// @returns count of triangles loaded into this mesh by this call
+static inline uint32_t readLittleEndian32(const uint8_t* bytes) {
+	uint8_t tmp[4];
+	memcpy(tmp, bytes, 4);
+	convertFromLittleEndian32(tmp);
+	uint32_t val;
+	memcpy(&val, tmp, 4);
+	return val;
+}
 
-size_t Meshy::readStlFile(const char* stlFilename) {
-	// NOTE: for stl legacy read-in reasons, we are using floats here,
-	// instead of our own Scalar type
-
-	struct vertexes_t {
-		float nx, ny, nz;
-		float x1, y1, z1;
-		float x2, y2, z2;
-		float x3, y3, z3;
-		uint16_t attrBytes;
-	};
-
-	union {
-		struct vertexes_t vertexes;
-		uint8_t bytes[sizeof(vertexes_t)];
-	} tridata;
-
-	union {
-		uint32_t intval;
-		uint16_t shortval;
-		uint8_t bytes[4];
-	} intdata;
+/// binary STL: 80 byte header, 32 bit face count, then 50 byte records
+static const size_t STL_HEADER_SIZE = 80 + 4;
+static const size_t STL_RECORD_SIZE = 3 * 4 * 4 + 2;
+
+/// True when the face count in the header accounts for exactly the size 
+/// of the file, which some exporters give to binary files whose header 
+/// starts with "solid".
+static bool binaryStlSizeMatches(const uint8_t* data, size_t size) {
+	if (size < STL_HEADER_SIZE)
+		return false;
+	uint64_t tricount = readLittleEndian32(data + 80);
+	return STL_HEADER_SIZE + STL_RECORD_SIZE * tricount == size;
+}
 
-	size_t facecount = 0;
+static inline float readLittleEndianFloat(const uint8_t* bytes) {
+	uint8_t tmp[4];
+	memcpy(tmp, bytes, 4);
+	convertFromLittleEndian32(tmp);
+	float val;
+	memcpy(&val, tmp, 4);
+	return val;
+}
 
-	uint8_t buf[512];
-	FILE *fHandle = fopen(stlFilename, "rb");
-	if (!fHandle) {
+/**
+ Read-only view of a whole file. Maps the file into memory where the
+ platform allows it and otherwise reads it into a private buffer, so
+ callers can decode straight from the returned bytes.
+ */
+class StlFileView {
+public:
+	StlFileView(const char* fileName) : bytes(NULL), byteCount(0)
+#ifndef WIN32
+			, mapped(false)
+#endif
+	{
+#ifdef WIN32
+		FILE* fHandle = fopen(fileName, "rb");
+		if (!fHandle)
+			throwCantOpen(fileName);
+		char chunk[1 << 16];
+		size_t got;
+		while ((got = fread(chunk, 1, sizeof(chunk), fHandle)) > 0)
+			buffer.insert(buffer.end(), chunk, chunk + got);
+		fclose(fHandle);
+		byteCount = buffer.size();
+		if (byteCount)
+			bytes = &buffer[0];
+#else
+		int fd = open(fileName, O_RDONLY);
+		if (fd < 0)
+			throwCantOpen(fileName);
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			close(fd);
+			throwCantOpen(fileName);
+		}
+		void* addr = MAP_FAILED;
+		if (S_ISREG(info.st_mode) && info.st_size > 0) {
+			byteCount = info.st_size;
+			addr = mmap(NULL, byteCount, PROT_READ, MAP_PRIVATE, fd, 0);
+		}
+		if (addr != MAP_FAILED) {
+			madvise(addr, byteCount, MADV_SEQUENTIAL);
+			bytes = static_cast<const uint8_t*>(addr);
+			mapped = true;
+		} else {
+			// not mappable (pipes, some network mounts), read it instead
+			readAll(fd);
+		}
+		close(fd);
+#endif
+	}
+	~StlFileView() {
+#ifndef WIN32
+		if (mapped)
+			munmap(const_cast<uint8_t*>(bytes), byteCount);
+#endif
+	}
+	const uint8_t* data() const { return bytes; }
+	size_t size() const { return byteCount; }
+private:
+#ifndef WIN32
+	/// reads @a fd to its end, which pipes only tell by reaching it
+	void readAll(int fd) {
+		size_t got = 0;
+		while (true) {
+			if (buffer.size() - got < (1 << 16))
+				buffer.resize(got + (1 << 16));
+			ssize_t r = read(fd, &buffer[got], buffer.size() - got);
+			if (r <= 0)
+				break;
+			got += r;
+		}
+		buffer.resize(got);
+		byteCount = got;
+		bytes = byteCount ? &buffer[0] : NULL;
+	}
+#endif
+	static void throwCantOpen(const char* fileName) {
 		string msg = "Can't open \"";
-		msg += stlFilename;
+		msg += fileName;
 		msg += "\". Check that the file name is correct and that you have sufficient privileges to open it.";
 		MeshyException problem(msg.c_str());
 		throw(problem);
 	}
+	// not copyable, the destructor owns the mapping
+	StlFileView(const StlFileView&);
+	StlFileView& operator=(const StlFileView&);
+
+	const uint8_t* bytes;
+	size_t byteCount;
+	std::vector<uint8_t> buffer;
+#ifndef WIN32
+	bool mapped;
+#endif
+};
 
-	if (fread(buf, 1, 5, fHandle) < 5) {
+/// Loads an STL file into a mesh object, from a binary or ASCII stl file.
+/// Files starting with "solid" are ASCII unless their size is exactly 
+/// what the binary face count gives.
+///
+/// @param stlFilename target file to load into the specified mesh
+///
+/// @returns count of triangles loaded into this mesh by this call
+
+size_t Meshy::readStlFile(const char* stlFilename) {
+	StlFileView stlFile(stlFilename);
+
+	if (stlFile.size() < 5) {
 		string msg = "\"";
 		msg += stlFilename;
 		msg += "\" is empty!";
 		MeshyException problem(msg.c_str());
 		throw(problem);
 	}
-	bool isBinary = true;
 
 	string solid_string = "solid";
-	buf[5] = '\0';
-	string test_string((const char*) buf);
+	string test_string((const char*) stlFile.data(), 5);
 	transform(test_string.begin(), test_string.end(), test_string.begin(), ::tolower);
 
-	isBinary = (test_string.compare(solid_string) != 0);
-
-	if (isBinary) {
-		// Binary STL file
-		// Skip remainder of 80 character comment field
-		if (fread(buf, 1, 75, fHandle) < 75) {
-			string msg = "\"";
-			msg += stlFilename;
-			msg += "\" is not a valid stl file";
-			MeshyException problem(msg.c_str());
-			throw(problem);
-		}
-		// Read in triangle count
-		if (fread(intdata.bytes, 1, 4, fHandle) < 4) {
-			string msg = "\"";
-			msg += stlFilename;
-			msg += "\" is not a valid stl file";
-			MeshyException problem(msg.c_str());
-			throw(problem);
-		}
-		convertFromLittleEndian32(intdata.bytes);
-		uint32_t tricount = intdata.intval;
-		int countdown = (int) tricount;
-		while (!feof(fHandle) && countdown-- > 0) {
-			if (fread(tridata.bytes, 1, 3 * 4 * 4 + 2, fHandle) < 3 * 4 * 4 + 2) {
-				Log::info() << __FUNCTION__ << "BREAKING" << endl;
-				break;
-			}
-			for (int i = 0; i < 3 * 4; i++) {
-				convertFromLittleEndian32(tridata.bytes + i * 4);
-			}
-			convertFromLittleEndian16((uint8_t*) & tridata.vertexes.attrBytes);
+	if (test_string.compare(solid_string) != 0 || 
+			binaryStlSizeMatches(stlFile.data(), stlFile.size())) {
+		readBinaryStl(stlFilename, stlFile.data(), stlFile.size());
+	} else {
+		readAsciiStl(stlFilename, (const char*) stlFile.data(), 
+				stlFile.size());
+	}
+	return this->triangleCount();
+}
 
-			vertexes_t &v = tridata.vertexes;
-			Point3Type pt1(v.x1, v.y1, v.z1);
-			Point3Type pt2(v.x2, v.y2, v.z2);
-			Point3Type pt3(v.x3, v.y3, v.z3);
+/// Decodes a binary STL image already in memory. The header count is used
+/// to size allTriangles once; each record is then decoded in place, in
+/// parallel chunks for large meshes.
 
-			Triangle3Type triangle(pt1, pt2, pt3);
-			bufferTriangle(triangle);
+void Meshy::readBinaryStl(const char* stlFilename, const uint8_t* data, 
+		size_t size) {
+	if (size < STL_HEADER_SIZE) {
+		string msg = "\"";
+		msg += stlFilename;
+		msg += "\" is not a valid stl file";
+		MeshyException problem(msg.c_str());
+		throw(problem);
+	}
+	uint32_t tricount = readLittleEndian32(data + 80);
+	size_t facecount = (size - STL_HEADER_SIZE) / STL_RECORD_SIZE;
+	if (facecount > tricount)
+		facecount = tricount;
+
+	/// Throw removed to continue coding progress. We may not expect all
+	/// triangles to load, depending on situation. Needs debugging/revision
+	if (facecount != tricount) {
+		stringstream msg;
+		msg << "Warning: triangle count err in \"";
+		msg << stlFilename;
+		msg << "\".  Expected: ";
+		msg << tricount;
+		msg << ", Read:";
+		msg << facecount;
+		Log::info() << msg.str();
+	}
 
-			facecount++;
-		}
+	flushBuffer();
+	size_t first = allTriangles.size();
+	allTriangles.resize(first + facecount);
+
+	const uint8_t* records = data + STL_HEADER_SIZE;
+	long faceTotal = static_cast<long>(facecount);
+#ifdef OMPFF
+	// below this many faces thread startup costs more than it saves
+	static const size_t PARALLEL_MIN_FACES = 1 << 16;
+	int workers = workerCount(grueCfg.get_threadCount());
+	#pragma omp parallel for schedule(static) num_threads(workers) \
+			if(facecount >= PARALLEL_MIN_FACES)
+#endif
+	for (long face = 0; face < faceTotal; face++) {
+		// skip the facet normal, it is recomputed from the winding
+		const uint8_t* v = records + face * STL_RECORD_SIZE + 3 * 4;
+		Point3Type pt1(readLittleEndianFloat(v), 
+				readLittleEndianFloat(v + 4), 
+				readLittleEndianFloat(v + 8));
+		Point3Type pt2(readLittleEndianFloat(v + 12), 
+				readLittleEndianFloat(v + 16), 
+				readLittleEndianFloat(v + 20));
+		Point3Type pt3(readLittleEndianFloat(v + 24), 
+				readLittleEndianFloat(v + 28), 
+				readLittleEndianFloat(v + 32));
+		allTriangles[first + face] = Triangle3Type(pt1, pt2, pt3);
+	}
 
-		/// Throw removed to continue coding progress. We may not expect all
-		/// triangles to load, depending on situation. Needs debugging/revision
-		if (this->triangleCount() != tricount) {
-			stringstream msg;
-			msg << "Warning: triangle count err in \"";
-			msg << stlFilename;
-			msg << "\".  Expected: ";
-			msg << tricount;
-			msg << ", Read:";
-			msg << triangleCount();
-			msg << ", faced:";
-			msg << facecount;
-			Log::info() << msg.str();
-			//			MeshyException problem(msg.c_str());
-			//			throw (problem);
-		}
+	for (size_t i = first; i < allTriangles.size(); i++) {
+		const Triangle3Type& t = allTriangles[i];
+		limits.grow(t[0]);
+		limits.grow(t[1]);
+		limits.grow(t[2]);
+	}
+}
 
+/**
+ Whitespace tokenizer over an in-memory ASCII STL image. Numbers are
+ converted without copying when they fit the exact float fast path,
+ otherwise the token goes through strtof, so values always match what
+ the stdio based reader produced.
+ */
+class AsciiStlReader {
+public:
+	AsciiStlReader(const char* fileName, const char* data, size_t size, 
+			bool strictMode)
+		: stlFilename(fileName), cur(data), end(data + size), line(1), 
+		strict(strictMode) {}
+
+	/// skips the rest of the line, used for the "solid name" header
+	void skipLine() {
+		while (cur < end && *cur != '\n')
+			cur++;
+	}
+	/// reads the next whitespace delimited token, false at end of file
+	bool word(const char*& tok, size_t& len) {
+		while (cur < end && isSpace(*cur)) {
+			if (*cur == '\n')
+				line++;
+			cur++;
+		}
+		if (cur == end)
+			return false;
+		tok = cur;
+		while (cur < end && !isSpace(*cur))
+			cur++;
+		len = cur - tok;
+		return true;
+	}
+	/// consumes a keyword; lenient mode accepts any token in its place
+	void keyword(const char* expected, size_t face) {
+		const char* tok;
+		size_t len;
+		if (!word(tok, len))
+			fail(face, expected);
+		if (strict && !matches(tok, len, expected))
+			fail(face, expected);
+	}
+	float number(size_t face) {
+		const char* tok;
+		size_t len;
+		if (!word(tok, len))
+			fail(face, "a number");
+		float val;
+		if (!parseFloat(tok, len, val))
+			fail(face, "a number");
+		return val;
+	}
+	bool atEnd() const { return cur == end; }
+	bool isStrict() const { return strict; }
+
+	static bool matches(const char* tok, size_t len, const char* expected) {
+		size_t i = 0;
+		for (; i < len && expected[i]; i++) {
+			if (tolower((unsigned char) tok[i]) != expected[i])
+				return false;
+		}
+		return i == len && expected[i] == '\0';
+	}
+	void fail(size_t face, const char* expected) const {
+		stringstream msg;
+		msg << "Error reading face " << face << " in file \"" << 
+				stlFilename << "\" (line " << line << "): expected " << 
+				expected;
+		MeshyException problem(msg.str().c_str());
+		throw(problem);
+	}
 
-	} else {
-		// ASCII STL file
-		// Gobble remainder of solid name line.
-		char* c = fgets((char*) buf, sizeof(buf), fHandle);
-		while (!feof(fHandle)) {
-			int q = fscanf(fHandle, "%80s", buf);
-			test_string = (const char*) (buf);
-			transform(test_string.begin(), test_string.end(), test_string.begin(), ::tolower);
-			string endsolid_string("endsolid");
-			if (test_string == endsolid_string) {
-				break;
+private:
+	static bool isSpace(char c) {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t' || 
+				c == '\v' || c == '\f';
+	}
+	static bool parseFloat(const char* tok, size_t len, float& val) {
+		// powers of ten that are exact in a float
+		static const float exactPowers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 
+				1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+		const char* p = tok;
+		const char* e = tok + len;
+		bool negative = false;
+		if (p < e && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+		uint64_t mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		bool any = false;
+		for (; p < e && *p >= '0' && *p <= '9'; p++, any = true) {
+			if (mantissa || *p != '0')
+				digits++;
+			mantissa = mantissa * 10 + (*p - '0');
+		}
+		if (p < e && *p == '.') {
+			for (p++; p < e && *p >= '0' && *p <= '9'; p++, any = true) {
+				if (mantissa || *p != '0')
+					digits++;
+				mantissa = mantissa * 10 + (*p - '0');
+				exponent--;
 			}
-			vertexes_t &v = tridata.vertexes;
-			bool success = true;
-			if (fscanf(fHandle, "%*s %f %f %f", &v.nx, &v.ny, &v.nz) < 3)
-				success = false;
-			if (fscanf(fHandle, "%*s %*s") < 0)
-				success = false;
-			if (fscanf(fHandle, "%*s %f %f %f", &v.x1, &v.y1, &v.z1) < 3)
-				success = false;
-			if (fscanf(fHandle, "%*s %f %f %f", &v.x2, &v.y2, &v.z2) < 3)
-				success = false;
-			if (fscanf(fHandle, "%*s %f %f %f", &v.x3, &v.y3, &v.z3) < 3)
-				success = false;
-			if (fscanf(fHandle, "%*s") < 0)
-				success = false;
-			if (fscanf(fHandle, "%*s") < 0)
-				success = false;
-			if (!success) {
-				stringstream msg;
-				msg << "Error reading face " << facecount << " in file \"" << stlFilename << "\"";
-				MeshyException problem(msg.str().c_str());
-				Log::info() << msg << endl;
-				Log::info() << buf << endl;
-				Log::info() << c << " " << q << endl;
-				throw(problem);
+		}
+		if (any && p < e && (*p == 'e' || *p == 'E')) {
+			const char* q = p + 1;
+			bool negExp = false;
+			if (q < e && (*q == '-' || *q == '+'))
+				negExp = *q++ == '-';
+			int expDigits = 0;
+			int exp = 0;
+			for (; q < e && *q >= '0' && *q <= '9'; q++, expDigits++) {
+				if (exp < 10000)
+					exp = exp * 10 + (*q - '0');
 			}
-			Triangle3Type triangle(Point3Type(v.x1, v.y1, v.z1), Point3Type(v.x2, v.y2, v.z2), Point3Type(v.x3, v.y3, v.z3));
-			bufferTriangle(triangle);
-
-			facecount++;
+			if (expDigits) {
+				exponent += negExp ? -exp : exp;
+				p = q;
+			}
+		}
+		// a float multiply or divide of two exact operands rounds once,
+		// which gives the correctly rounded result strtof would
+		if (any && p == e && digits <= 19 && mantissa <= (1 << 24) && 
+				exponent >= -10 && exponent <= 10) {
+			float f = static_cast<float>(mantissa);
+			if (exponent < 0)
+				f /= exactPowers[-exponent];
+			else
+				f *= exactPowers[exponent];
+			val = negative ? -f : f;
+			return true;
 		}
+		char buf[128];
+		if (len >= sizeof(buf))
+			return false;
+		memcpy(buf, tok, len);
+		buf[len] = '\0';
+		char* stop;
+		val = strtof(buf, &stop);
+		return stop == buf + len;
 	}
-	fclose(fHandle);
+
+	const char* stlFilename;
+	const char* cur;
+	const char* end;
+	size_t line;
+	bool strict;
+};
+
+/// Parses an ASCII STL image already in memory. In strict mode every
+/// keyword is checked and the file must close with endsolid; otherwise
+/// keywords are only counted, as the stdio reader did, and a file cut
+/// off before endsolid keeps the facets that were complete. Either way a 
+/// file without a single facet is an error.
+
+void Meshy::readAsciiStl(const char* stlFilename, const char* data, 
+		size_t size) {
+	AsciiStlReader reader(stlFilename, data, size, grueCfg.get_strictStl());
+	// Gobble remainder of solid name line.
+	reader.skipLine();
+
 	flushBuffer();
-	return this->triangleCount();
+	size_t facecount = 0;
+	Point3Type pts[3];
+	while (true) {
+		const char* tok;
+		size_t len;
+		if (!reader.word(tok, len)) {
+			if (reader.isStrict())
+				reader.fail(facecount, "endsolid");
+			Log::info() << "Warning: missing endsolid in \"" << 
+					stlFilename << "\"" << endl;
+			break;
+		}
+		if (AsciiStlReader::matches(tok, len, "endsolid"))
+			break;
+		if (reader.isStrict() && 
+				!AsciiStlReader::matches(tok, len, "facet"))
+			reader.fail(facecount, "facet");
+		try {
+			// facet normal, recomputed from the winding
+			reader.keyword("normal", facecount);
+			reader.number(facecount);
+			reader.number(facecount);
+			reader.number(facecount);
+			reader.keyword("outer", facecount);
+			reader.keyword("loop", facecount);
+			for (int i = 0; i < 3; i++) {
+				reader.keyword("vertex", facecount);
+				float x = reader.number(facecount);
+				float y = reader.number(facecount);
+				float z = reader.number(facecount);
+				pts[i] = Point3Type(x, y, z);
+			}
+			reader.keyword("endloop", facecount);
+			reader.keyword("endfacet", facecount);
+		} catch (MeshyException&) {
+			if (reader.isStrict() || !reader.atEnd())
+				throw;
+			Log::info() << "Warning: incomplete face " << facecount << 
+					" dropped in \"" << stlFilename << "\"" << endl;
+			break;
+		}
 
+		allTriangles.push_back(Triangle3Type(pts[0], pts[1], pts[2]));
+		limits.grow(pts[0]);
+		limits.grow(pts[1]);
+		limits.grow(pts[2]);
+		facecount++;
+	}
+	if (facecount == 0) {
+		string msg = "\"";
+		msg += stlFilename;
+		msg += "\" has no facets";
+		MeshyException problem(msg.c_str());
+		throw(problem);
+	}
 }
 
 void Meshy::alignToPlate() {
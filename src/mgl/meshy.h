@@ -17,6 +17,7 @@
 #include <set>
 #include <fstream>
 #include <list>
+#include <stdint.h>
 
 #ifdef OMPFF
 #include <omp.h>
@@ -120,6 +121,11 @@ public:
 	void alignToPlate();
 	void translate(const Point3Type &change);
 private:
+	void readBinaryStl(const char* stlFilename, const uint8_t* data, 
+			size_t size);
+	void readAsciiStl(const char* stlFilename, const char* data, 
+			size_t size);
+
     const GrueConfig& grueCfg;
 };
 
@@ -23,6 +23,10 @@
 #include <json/value.h>
 #include <json/writer.h>
 
+#ifdef OMPFF
+#include <omp.h>
+#endif
+
 #include "meshy.h"
 #include "shrinky.h"
 #include "ScadDebugFile.h"
@@ -43,6 +47,14 @@ string getMiracleGrueVersionStr() {
 	return "v 0.04";
 }
 
+unsigned int workerCount(unsigned int threadCount) {
+#ifdef OMPFF
+	return threadCount ? threadCount : omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
 ostream& operator<<(ostream& os, const Point3Type& v) {
 	os << "[" << v[0] << ", " << v[1] << ", " << v[2] << "]";
 	return os;
@@ -77,8 +89,8 @@ bool LayerMeasure::LayerAttributes::isAbsolute() const {
 }
 LayerMeasure::LayerMeasure(Scalar firstLayerZ, Scalar layerH, Scalar widthRatio) 
 		: firstLayerZ(firstLayerZ), layerH(layerH), 
-		layerWidthRatio(widthRatio), issuedIndex(256) {
-	attributes[0] = LayerAttributes(0, 0, widthRatio);
+		layerWidthRatio(widthRatio), issuedIndex(FIRST_ISSUED_INDEX) {
+	attributes.push_back(LayerAttributes(0, 0, widthRatio));
 	attributes[0].base = -1;
 }
 layer_measure_index_t LayerMeasure::zToLayerAbove(Scalar z) const {
@@ -108,33 +120,67 @@ void LayerMeasure::setLayerH(Scalar h) {
 void LayerMeasure::setLayerWidthRatio(Scalar wr) {
 	layerWidthRatio = wr;
 }
-const LayerMeasure::LayerAttributes& LayerMeasure::getLayerAttributes(
-		layer_measure_index_t layerIndex) const {
-	attributesMap::const_iterator iter = attributes.find(layerIndex);
-	if(iter == attributes.end()){
+size_t LayerMeasure::attributesSlot(layer_measure_index_t layerIndex) const {
+	if(layerIndex != 0 && 
+			(layerIndex < FIRST_ISSUED_INDEX || layerIndex >= issuedIndex)){
 		stringstream msg;
 		msg << "Unable to find attributes for layer index " << layerIndex;
 		LayerException mixup = msg.str();
 		throw mixup;
 	}
-	return iter->second;
+	return layerIndex == 0 ? 0 : layerIndex - FIRST_ISSUED_INDEX + 1;
+}
+void LayerMeasure::forgetPositions() {
+	positions.clear();
+	positionKnown.clear();
+}
+const LayerMeasure::LayerAttributes& LayerMeasure::getLayerAttributes(
+		layer_measure_index_t layerIndex) const {
+	return attributes[attributesSlot(layerIndex)];
 }
 LayerMeasure::LayerAttributes& LayerMeasure::getLayerAttributes(
 		layer_measure_index_t layerIndex) {
-	attributesMap::iterator iter = attributes.find(layerIndex);
-	if(iter == attributes.end()){
-		stringstream msg;
-		msg << "Unable to find attributes for layer index " << layerIndex;
-		LayerException mixup = msg.str();
-		throw mixup;
-	}
-	return iter->second;
+	LayerAttributes& attribs = attributes[attributesSlot(layerIndex)];
+	forgetPositions();
+	return attribs;
 }
 Scalar LayerMeasure::getLayerPosition(layer_measure_index_t layerIndex) const {
 	if(layerIndex < 0)
 		return 0.0;
-	const LayerAttributes& currentAttribs = getLayerAttributes(layerIndex);
-	return currentAttribs.delta + getLayerPosition(currentAttribs.base);
+	size_t slot = attributesSlot(layerIndex);
+	if(positions.size() != attributes.size()){
+		positions.assign(attributes.size(), 0.0);
+		positionKnown.assign(attributes.size(), false);
+	}
+	if(positionKnown[slot])
+		return positions[slot];
+	//walk down the bases to an absolute layer or one already known
+	std::vector<size_t> chain;
+	Scalar position = 0.0;
+	for(layer_measure_index_t current = layerIndex; current >= 0; 
+			current = attributes[chain.back()].base){
+		size_t currentSlot = attributesSlot(current);
+		if(positionKnown[currentSlot]){
+			position = positions[currentSlot];
+			break;
+		}
+		if(chain.size() == attributes.size()){
+			stringstream msg;
+			msg << "Layer index " << layerIndex << " is relative to itself";
+			LayerException mixup = msg.str();
+			throw mixup;
+		}
+		chain.push_back(currentSlot);
+	}
+	//and back up, each layer is its delta above its base
+	for(std::vector<size_t>::reverse_iterator iter = chain.rbegin(); 
+			iter != chain.rend(); 
+			++iter){
+		position = attributes[*iter].delta + position;
+		positions[*iter] = position;
+		positionKnown[*iter] = true;
+	}
+	return position;
 }
 Scalar LayerMeasure::getLayerThickness(layer_measure_index_t layerIndex) const {
 	return getLayerAttributes(layerIndex).thickness;
@@ -145,7 +191,8 @@ Scalar LayerMeasure::getLayerWidth(layer_measure_index_t layerIndex) const {
 }
 layer_measure_index_t LayerMeasure::createAttributes(
 		const LayerAttributes& attribs) {
-	attributes[issuedIndex] = attribs;
+	attributes.push_back(attribs);
+	forgetPositions();
 	return issuedIndex++;
 }
 
@@ -43,6 +43,10 @@ static const Scalar M_TAU = M_PI * 2;
 std::string getMiracleGrueProgramName();
 std::string getMiracleGrueVersionStr();
 
+/// Threads to run a parallel stage on: @a threadCount, or one per core 
+/// when it is 0. Always 1 in single threaded builds.
+unsigned int workerCount(unsigned int threadCount);
+
 typedef libthing::Vector2 Point2Type;
 typedef libthing::Vector3 Point3Type;
 typedef libthing::LineSegment2 Segment2Type;
@@ -135,7 +139,13 @@ public:
 	
 	/* New interface */
 	const LayerAttributes& getLayerAttributes(layer_measure_index_t layerIndex) const;
+	/// Layer positions are cached, and getting attributes for writing 
+	/// drops the cache. Don't keep the reference around to change them 
+	/// after reading a position.
 	LayerAttributes& getLayerAttributes(layer_measure_index_t layerIndex);
+	/// Absolute position of a layer, following its chain of bases. 
+	/// Positions are worked out once and cached until attributes change, 
+	/// so calls that fill the cache must not run concurrently.
 	Scalar getLayerPosition(layer_measure_index_t layerIndex) const;
 	Scalar getLayerThickness(layer_measure_index_t layerIndex) const;
 	Scalar getLayerWidth(layer_measure_index_t layerIndex) const;
@@ -145,19 +155,25 @@ public:
 	
 
 private:
+	/// first index handed out by createAttributes, 0 is the bed
+	static const layer_measure_index_t FIRST_ISSUED_INDEX = 256;
 	
-	class InternalAttributes {
-	public:
-		
-	};
-	
-	typedef std::map<layer_measure_index_t, LayerAttributes> attributesMap;
+	typedef std::vector<LayerAttributes> attributesVector;
+
+	/// where the attributes of a layer index are stored
+	size_t attributesSlot(layer_measure_index_t layerIndex) const;
+	void forgetPositions();
 
 	Scalar firstLayerZ;
 	Scalar layerH;
 	Scalar layerWidthRatio;
 
-	attributesMap attributes;
+	/// layer 0, then the issued indices in order
+	attributesVector attributes;
+	
+	/// absolute positions by slot, valid where positionKnown is set
+	mutable std::vector<Scalar> positions;
+	mutable std::vector<bool> positionKnown;
 	
 	layer_measure_index_t issuedIndex;
 };
@@ -2,6 +2,9 @@
 
 #include "configuration.h"
 #include <json/writer.h>
+#include <algorithm>
+#include <climits>
+#include <iterator>
 
 // #include "abstractable.h"
 #include "miracle.h"
@@ -13,40 +16,210 @@ using namespace Json;
 
 
 
+/**
+ @brief Work out which slices are needed to region the output layers 
+ [@a firstLayer, @a lastLayer], counted with raft layers.
+ Infill of a layer depends on the floors of floorLayerCount slices down 
+ and the roofs of roofLayerCount slices up, and each of those on the 
+ slice next to it. Support comes down from every slice above, so it 
+ widens the range further. Rafts are built from the bottom slice, which 
+ sliceBottom adds on its own, but with support that slice takes in 
+ every other slice, so the range then starts at the bottom.
+ @param sliceBegin first slice needed
+ @param sliceEnd one past the last slice needed
+ */
+static void neededSlices(const GrueConfig& grueCfg, 
+		size_t firstLayer, size_t lastLayer, 
+		size_t& sliceBegin, size_t& sliceEnd) {
+	size_t raftLayers = grueCfg.get_doRaft() ? grueCfg.get_raftLayers() : 0;
+	size_t firstSlice = firstLayer > raftLayers ? firstLayer - raftLayers : 0;
+	size_t lastSlice = lastLayer > raftLayers ? lastLayer - raftLayers : 0;
+	sliceBegin = firstSlice > grueCfg.get_floorLayerCount() ? 
+			firstSlice - grueCfg.get_floorLayerCount() : 0;
+	sliceEnd = lastSlice + grueCfg.get_roofLayerCount() + 1;
+	if (grueCfg.get_doSupport()) {
+		sliceEnd = INT_MAX;
+		if (grueCfg.get_doRaft())
+			sliceBegin = 0;
+	}
+}
+
+/**
+ @brief Slice the bottom slice into @a bottom when rafts are built from it 
+ but the slices needed start above it.
+ */
+static void sliceBottom(const GrueConfig& grueCfg, const Meshy& mesh, 
+		Slicer& slicer, size_t sliceBegin, 
+		LayerLoops::layer_iterator bottom) {
+	if (!grueCfg.get_doRaft() || sliceBegin == 0)
+		return;
+	Segmenter segmenter(grueCfg);
+	segmenter.tablaturize(mesh, 0, 1);
+	slicer.loopsForSlices(segmenter, bottom, 0, 1);
+}
+
+/// slices sliced, processed and regioned at a time when streaming
+static const size_t STREAM_WINDOW_LAYERS = 16;
+
+/**
+ @brief Run the whole pipeline a window of slices at a time, writing each 
+ layer out as soon as the layers above it can no longer change it.
+ Apart from the mesh, only the regions of a few windows are held at once, 
+ and the G-code starts after the first few windows. Support is built from 
+ every layer above, so this is only used without it.
+ */
+static void streamModel(const GrueConfig& grueCfg, 
+		const char *modelFile, 
+		ostream& gcodeFile, 
+		size_t firstLayer, 
+		size_t lastLayer, 
+		RegionList &regions, 
+		ProgressBar *progress) {
+	size_t sliceBegin, sliceEnd;
+	neededSlices(grueCfg, firstLayer, lastLayer, sliceBegin, sliceEnd);
+
+	Meshy mesh(grueCfg);
+	mesh.readStlFile(modelFile);
+	mesh.alignToPlate();
+	Limits limits = mesh.readLimits();
+	Segmenter segmenter(grueCfg);
+	segmenter.tablaturize(mesh, sliceBegin, sliceEnd);
+	sliceEnd = std::min(sliceEnd, segmenter.sliceCount());
+
+	/*
+	 Every slice has an empty layer up front, for its layer measure id. 
+	 A window of them is filled in, processed and regioned, then emptied 
+	 again, the regions keep their own copy of the outlines. The pather 
+	 reports progress for the whole pipeline.
+	 */
+	Slicer slicer(grueCfg, NULL);
+	LayerLoops layerloops(grueCfg.get_firstLayerZ(), grueCfg.get_layerH());
+	slicer.beginLoops(segmenter, layerloops);
+	LayerMeasure& layerMeasure = layerloops.layerMeasure;
+	LoopProcessor processor(grueCfg, NULL);
+	Regioner regioner(grueCfg, NULL);
+	Grid grid;
+	regioner.beginSkeleton(layerloops, layerMeasure, regions, limits, grid);
+
+	Pather pather(grueCfg, progress);
+	GCoder gcoder(grueCfg, NULL);
+	size_t block = workerCount(grueCfg.get_threadCount());
+	size_t window = std::max(STREAM_WINDOW_LAYERS, block);
+	size_t endLayer = std::min(lastLayer + 1, regions.size());
+	firstLayer = std::min(firstLayer, endLayer);
+	pather.beginPaths(firstLayer, endLayer);
+	gcoder.beginGcode(gcodeFile, modelFile, endLayer - firstLayer, 
+			firstLayer);
+
+	LayerPaths layers;
+	size_t written = 0;
+	LayerLoops::layer_iterator windowBegin = layerloops.begin();
+	for (size_t slice = 0; 
+			slice < segmenter.sliceCount() && written < endLayer; 
+			slice += window) {
+		size_t windowEnd = std::min(slice + window, segmenter.sliceCount());
+		LayerLoops::layer_iterator windowLast = windowBegin;
+		std::advance(windowLast, windowEnd - slice);
+		//slices outside the needed ones are left empty
+		size_t cutBegin = std::min(std::max(slice, sliceBegin), windowEnd);
+		size_t cutEnd = std::max(std::min(windowEnd, sliceEnd), cutBegin);
+		LayerLoops::layer_iterator cut = windowBegin;
+		std::advance(cut, cutBegin - slice);
+		slicer.loopsForSlices(segmenter, cut, cutBegin, cutEnd);
+		if (slice == 0)
+			sliceBottom(grueCfg, mesh, slicer, cutBegin, windowBegin);
+		for (LayerLoops::layer_iterator layer = windowBegin; 
+				layer != windowLast; ++layer) {
+			LayerLoops::Layer processed(layer->getIndex());
+			processor.processLayer(*layer, processed);
+			*layer = processed;
+		}
+
+		size_t done = regioner.appendSkeleton(windowBegin, windowLast, 
+				layerMeasure, regions, grid);
+		for (; windowBegin != windowLast; ++windowBegin)
+			*windowBegin = LayerLoops::Layer(windowBegin->getIndex());
+
+		done = std::min(done, endLayer);
+		for (size_t first = std::max(written, firstLayer); first < done; 
+				first += block) {
+			size_t last = std::min(first + block, done);
+			pather.appendPaths(grueCfg, regions, layerMeasure, grid, layers, 
+					first, last);
+			for (LayerPaths::layer_iterator layer = layers.begin(); 
+					layer != layers.end(); 
+					++layer) {
+				gcoder.writeLayer(gcodeFile, layers, layer);
+			}
+			layers.erase(layers.begin(), layers.end());
+		}
+		for (; written < done; ++written) {
+			LayerRegions empty;
+			empty.layerMeasureId = regions[written].layerMeasureId;
+			regions[written] = empty;
+		}
+	}
+	gcoder.endGcode(gcodeFile);
+}
+
 //// @param slices list of output slice (output )
+//// @param firstSliceIdx first layer to write, -1 to start at the bottom
+//// @param lastSliceIdx last layer to write, -1 to end at the top
+//// Layers are counted with raft layers. Only the slices those layers 
+//// depend on are sliced, and only those layers are pathed and written.
 
 void mgl::miracleGrue(const GrueConfig& grueCfg, 
 		const char *modelFile,
 		const char *, // scadFileStr,
 		ostream& gcodeFile,
-		int, // firstSliceIdx,
-		int, // lastSliceIdx,
+		int firstSliceIdx,
+		int lastSliceIdx,
 		RegionList &regions,
 		std::vector< SliceData >&, // slices,
 		ProgressBar *progress) {
 
-	Meshy mesh(grueCfg);
-	mesh.readStlFile(modelFile);
-	mesh.alignToPlate();
-	
-	Limits limits = mesh.readLimits();
+	/*
+	 Each stage's input is released as soon as the stage is done with it, 
+	 so at most two representations of the model are held at a time. The 
+	 segmenter refers to the triangles of the mesh, so both go together.
+	 */
+	size_t firstLayer = firstSliceIdx > 0 ? size_t(firstSliceIdx) : 0;
+	size_t lastLayer = lastSliceIdx >= 0 ? size_t(lastSliceIdx) : INT_MAX;
+	if (grueCfg.get_streamLayers() && !grueCfg.get_doSupport()) {
+		streamModel(grueCfg, modelFile, gcodeFile, firstLayer, lastLayer, 
+				regions, progress);
+		return;
+	}
+	size_t sliceBegin, sliceEnd;
+	neededSlices(grueCfg, firstLayer, lastLayer, sliceBegin, sliceEnd);
+
+	Limits limits;
 	Grid grid;
+	LayerLoops layerloops(grueCfg.get_firstLayerZ(), grueCfg.get_layerH());
+	{
+		Meshy mesh(grueCfg);
+		mesh.readStlFile(modelFile);
+		mesh.alignToPlate();
 
-	Segmenter segmenter(grueCfg);
-	segmenter.tablaturize(mesh);
+		limits = mesh.readLimits();
 
-	Slicer slicer(grueCfg, progress);
-	LayerLoops layerloops(grueCfg.get_firstLayerZ(), grueCfg.get_layerH());
+		Segmenter segmenter(grueCfg);
+		segmenter.tablaturize(mesh, sliceBegin, sliceEnd);
 
-	//old interface
-	//slicer.tomographyze(segmenter, tomograph);
-	//new interface
-	slicer.generateLoops(segmenter, layerloops);
+		Slicer slicer(grueCfg, progress);
+
+		//old interface
+		//slicer.tomographyze(segmenter, tomograph);
+		//new interface
+		slicer.generateLoops(segmenter, layerloops, sliceBegin, sliceEnd);
+		if (!layerloops.empty())
+			sliceBottom(grueCfg, mesh, slicer, sliceBegin, layerloops.begin());
+	}
     
     LayerLoops processedLoops;
     
     LoopProcessor processor(grueCfg, progress);
-    processor.processLoops(layerloops, processedLoops);
+    processor.consumeLoops(layerloops, processedLoops);
     
     LayerMeasure& layerMeasure = processedLoops.layerMeasure;
 
@@ -58,12 +231,51 @@ void mgl::miracleGrue(const GrueConfig& grueCfg,
 	//new interface
 	regioner.generateSkeleton(processedLoops, layerMeasure, regions ,
 			limits, grid);
+	//only the layer measure is needed from here on
+	processedLoops.erase(processedLoops.begin(), processedLoops.end());
 
 	Pather pather(grueCfg, progress);
 
 	LayerPaths layers;
+	size_t endLayer = std::min(lastLayer + 1, regions.size());
+	firstLayer = std::min(firstLayer, endLayer);
+
+	if (grueCfg.get_streamLayers()) {
+		/*
+		 Support needs every layer regioned first, so only the paths are 
+		 streamed. Path a few layers, write them out and let them go. The 
+		 regions of a layer are released once it is written, so regions is 
+		 left holding only layer measure ids. The pather reports progress 
+		 for both stages.
+		 */
+		GCoder gcoder(grueCfg, NULL);
+		size_t block = workerCount(grueCfg.get_threadCount());
+		pather.beginPaths(firstLayer, endLayer);
+		gcoder.beginGcode(gcodeFile, modelFile, endLayer - firstLayer, 
+				firstLayer);
+		for (size_t first = firstLayer; first < endLayer; first += block) {
+			size_t last = std::min(first + block, endLayer);
+			pather.appendPaths(grueCfg, regions, layerMeasure, grid, layers, 
+					first, last);
+			for (LayerPaths::layer_iterator layer = layers.begin(); 
+					layer != layers.end(); 
+					++layer) {
+				gcoder.writeLayer(gcodeFile, layers, layer);
+			}
+			layers.erase(layers.begin(), layers.end());
+			for (size_t released = first; released < last; ++released) {
+				LayerRegions empty;
+				empty.layerMeasureId = regions[released].layerMeasureId;
+				regions[released] = empty;
+			}
+		}
+		gcoder.endGcode(gcodeFile);
+		return;
+	}
+
 	pather.generatePaths(grueCfg, regions,
-						 layerMeasure, grid, layers);
+						 layerMeasure, grid, layers, 
+						 firstLayer, endLayer - 1);
 
 	// pather.writeGcode(gcodeFileStr, modelFile, slices);
 	//std::ofstream gout(gcodeFile);
@@ -75,7 +287,7 @@ void mgl::miracleGrue(const GrueConfig& grueCfg,
 	//			modelFile, firstSliceIdx, lastSliceIdx);
 	//new interface
 	gcoder.writeGcodeFile(layers, layerMeasure, 
-			gcodeFile, modelFile);
+			gcodeFile, modelFile, layers.begin(), layers.end(), firstLayer);
 
 	//gout.close();
 
@@ -93,8 +305,13 @@ void mgl::getSliceJson(const GrueConfig& grueCfg,
 	Limits limits = mesh.readLimits();
 	Grid grid;
 
+	if (slicenum < 0)
+		return;
+
+	//only the requested slice is filled in and sliced, the other layers 
+	//are left empty
 	Segmenter segmenter(grueCfg);
-	segmenter.tablaturize(mesh);
+	segmenter.tablaturize(mesh, slicenum, slicenum + 1);
 
 	Slicer slicer(grueCfg, NULL);
 	LayerLoops layers(grueCfg.get_firstLayerZ(), grueCfg.get_layerH());
@@ -102,12 +319,12 @@ void mgl::getSliceJson(const GrueConfig& grueCfg,
 	//old interface
 	//slicer.tomographyze(segmenter, tomograph);
 	//new interface
-	slicer.generateLoops(segmenter, layers);
+	slicer.generateLoops(segmenter, layers, slicenum, slicenum + 1);
 
     LayerLoops processed;
     
     LoopProcessor processor(grueCfg, NULL);
-    processor.processLoops(layers, processed);
+    processor.consumeLoops(layers, processed);
 
     int thisslice = 0;
 
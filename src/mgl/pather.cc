@@ -11,6 +11,7 @@
 
 #include <list>
 #include <vector>
+#include <algorithm>
 
 #include "pather.h"
 #include "limits.h"
@@ -21,13 +22,25 @@ namespace mgl {
 using namespace std;
 
 Pather::Pather(const PatherConfig& pCfg, ProgressBar* progress) 
-		: Progressive(progress), patherCfg(pCfg) {}
+		: Progressive(progress), patherCfg(pCfg), pathDirection(false), 
+		pathOptimizer(NULL) {}
 Pather::Pather(const GrueConfig& grueConf, ProgressBar* progress)
-        : Progressive(progress) {
+        : Progressive(progress), pathDirection(false), pathOptimizer(NULL) {
     patherCfg.doGraphOptimization = grueConf.get_doGraphOptimization();
     patherCfg.coarseness = grueConf.get_coarseness();
     patherCfg.directionWeight = grueConf.get_directionWeight();
 }
+Pather::~Pather() {
+	delete pathOptimizer;
+}
+
+static abstract_optimizer* createOptimizer(const GrueConfig& grueCfg) {
+    if(grueCfg.get_doGraphOptimization()) {
+        return new pather_optimizer_fastgraph(grueCfg);
+    } else {
+        return new pather_optimizer();
+    }
+}
 
 void Pather::generatePaths(const GrueConfig& grueCfg,
 		const RegionList &skeleton,
@@ -44,37 +57,50 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
 		firstSliceIdx = (size_t) sfirstSliceIdx;
 	}
 
-	if (slastSliceIdx > 0) {
+	if (slastSliceIdx >= 0) {
 		lastSliceIdx = (size_t) slastSliceIdx;
 	}
 
-	bool direction = false;
-	unsigned int currentSlice = 0;
+	size_t endSliceIdx = std::min(lastSliceIdx + 1, skeleton.size());
+	beginPaths(firstSliceIdx, endSliceIdx);
+	appendPaths(grueCfg, skeleton, layerMeasure, grid, layerpaths, 
+			firstSliceIdx, endSliceIdx);
+}
 
-	initProgress("Path generation", skeleton.size());
-    
-    abstract_optimizer* optimizer = NULL;
-    if(grueCfg.get_doGraphOptimization()) {
-        optimizer = new pather_optimizer_fastgraph(grueCfg);
-    } else {
-        optimizer = new pather_optimizer();
-    }
+void Pather::beginPaths(size_t first, size_t last) {
+	pathDirection = false;
+	delete pathOptimizer;
+	pathOptimizer = NULL;
+	initProgress("Path generation", last > first ? last - first : 0);
+}
 
-	for (RegionList::const_iterator layerRegions = skeleton.begin();
-			layerRegions != skeleton.end(); ++layerRegions) {
-		tick();
+void Pather::advanceDirection(const GrueConfig& grueCfg, 
+		size_t currentSlice) {
+	//the regioner cast only the rays along this direction
+	pathDirection = infillAlongX(grueCfg, currentSlice);
+}
+
+void Pather::appendPaths(const GrueConfig& grueCfg,
+		const RegionList &skeleton,
+		const LayerMeasure &layerMeasure,
+		const Grid &grid,
+		LayerPaths &layerpaths,
+		size_t first,
+		size_t last) {
+	/*
+	 Create all the layers up front. Apart from the optimizer, the infill 
+	 direction is the only thing carried from one layer to the next, so it 
+	 is worked out here and the layers can then be filled independently.
+	 */
+	std::vector<unsigned int> slices;
+	std::vector<bool> directions;
+	std::vector<LayerPaths::Layer::ExtruderLayer*> extruderLayers;
+	for (size_t currentSlice = first; currentSlice < last; ++currentSlice) {
+		const LayerRegions& layerRegions = skeleton[currentSlice];
         try {
-		if (currentSlice < firstSliceIdx) continue;
-		if (currentSlice > lastSliceIdx) break;
-        if(grueCfg.get_doRaft() && currentSlice > 1 && 
-                currentSlice < grueCfg.get_raftLayers() && 
-                grueCfg.get_raftAligned()) {
-            //don't flip direction
-        } else {
-            direction = !direction;
-        }
+        advanceDirection(grueCfg, currentSlice);
 		const layer_measure_index_t layerMeasureId =
-				layerRegions->layerMeasureId;
+				layerRegions.layerMeasureId;
 
 		//adding these should be handled in gcoder
 		const Scalar z = layerMeasure.getLayerPosition(layerMeasureId);
@@ -89,19 +115,65 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
 		// it does not handle a dualstrusion print
 		lp_layer.extruders.push_back(
 				LayerPaths::Layer::ExtruderLayer(grueCfg.get_defaultExtruder()));
-		LayerPaths::Layer::ExtruderLayer& extruderlayer =
-				lp_layer.extruders.back();
-		
-		
-		optimizer->clearBoundaries();
-        optimizer->clearPaths();
+		slices.push_back(currentSlice);
+		directions.push_back(pathDirection);
+		extruderLayers.push_back(&lp_layer.extruders.back());
+        }catch (const std::exception& our) {
+            std::cout << "Error " << our.what() << " on layer " << 
+                    currentSlice << std::endl;
+        }
+	}
+	
+	int layerCount = extruderLayers.size();
+#ifdef OMPFF
+	/*
+	 The graph optimizer starts each layer where the previous one ended, 
+	 which can't be known ahead of time. When running on several threads 
+	 every layer gets an optimizer of its own instead, so layers start from 
+	 the configured starting point. This keeps the output independent of 
+	 scheduling, but it differs from a single threaded run.
+	 */
+	int workers = workerCount(grueCfg.get_threadCount());
+	if (workers > 1) {
+		#pragma omp parallel for schedule(dynamic) num_threads(workers)
+		for (int i = 0; i < layerCount; ++i) {
+			#pragma omp critical (pather_progress)
+			tick();
+			abstract_optimizer* optimizer = createOptimizer(grueCfg);
+			layerPaths(grueCfg, skeleton[slices[i]], grid, directions[i], 
+					*optimizer, *extruderLayers[i], slices[i]);
+			delete optimizer;
+		}
+		return;
+	}
+#endif
+	if (!pathOptimizer) {
+		pathOptimizer = createOptimizer(grueCfg);
+	}
+	for (int i = 0; i < layerCount; ++i) {
+		tick();
+		layerPaths(grueCfg, skeleton[slices[i]], grid, directions[i], 
+				*pathOptimizer, *extruderLayers[i], slices[i]);
+	}
+}
 
-		const std::list<LoopList>& insetLoops = layerRegions->insetLoops;
-		const std::list<OpenPathList>& spurPaths = layerRegions->spurs;
+void Pather::layerPaths(const GrueConfig& grueCfg, 
+		const LayerRegions& layerRegions, 
+		const Grid& grid, 
+		bool direction, 
+		abstract_optimizer& optimizer, 
+		LayerPaths::Layer::ExtruderLayer& extruderlayer, 
+		unsigned int currentSlice) {
+	try {
+		optimizer.clearBoundaries();
+        optimizer.clearPaths();
+
+		const std::list<LoopList>& insetLoops = layerRegions.insetLoops;
+		const std::list<OpenPathList>& spurPaths = layerRegions.spurs;
 		
         if(grueCfg.get_doOutlines()) {
-            for(LoopList::const_iterator iter = layerRegions->outlines.begin(); 
-                    iter != layerRegions->outlines.end(); 
+            for(LoopList::const_iterator iter = layerRegions.outlines.begin(); 
+                    iter != layerRegions.outlines.end(); 
                     ++iter) {
                 const LoopPath outlinePath(*iter, iter->clockwise(), 
                         iter->counterClockwise());
@@ -114,8 +186,8 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
                     path.appendPoint(*pointIter);
                 }
             }
-            for(LoopList::const_iterator iter = layerRegions->supportLoops.begin(); 
-                    iter != layerRegions->supportLoops.end(); 
+            for(LoopList::const_iterator iter = layerRegions.supportLoops.begin(); 
+                    iter != layerRegions.supportLoops.end(); 
                     ++iter) {
                 const LoopPath outlinePath(*iter, iter->clockwise(), 
                         iter->counterClockwise());
@@ -130,7 +202,7 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
             }
         }
 		
-		optimizer->addBoundaries(layerRegions->outlines);	
+		optimizer.addBoundaries(layerRegions.outlines);	
         
         bool hasInfill = grueCfg.get_doInfills() && 
                 grueCfg.get_infillDensity() > 0;
@@ -138,7 +210,7 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
                 grueCfg.get_floorLayerCount() > 0;
         
         if(!hasInfill && !hasSolidLayers) {
-            optimizer->addBoundaries(layerRegions->interiorLoops);
+            optimizer.addBoundaries(layerRegions.interiorLoops);
         }
         
 		if(grueCfg.get_doInsets()) {
@@ -148,7 +220,7 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
                     ++listIter) {
                 int shellVal = currentShell;
 
-                optimizer->addPaths(*listIter, 
+                optimizer.addPaths(*listIter, 
                         PathLabel(PathLabel::TYP_INSET, 
                         PathLabel::OWN_MODEL, shellVal));
                 ++currentShell;
@@ -159,15 +231,15 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
                 spurIter != spurPaths.end(); 
                     ++spurIter) {
                 int shellVal = currentShell;
-                optimizer->addPaths(*spurIter, 
+                optimizer.addPaths(*spurIter, 
                         PathLabel(PathLabel::TYP_INSET, 
                         PathLabel::OWN_MODEL, shellVal));
                 ++currentShell;
             }
         }
 
-		const GridRanges& infillRanges = layerRegions->infill;
-		const GridRanges& supportRanges = layerRegions->support;
+		const GridRanges& infillRanges = layerRegions.infill;
+		const GridRanges& supportRanges = layerRegions.support;
 
 		const std::vector<Scalar>& values = 
 				!direction ? grid.getXValues() : grid.getYValues();
@@ -192,27 +264,27 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
 				supportPaths);
 		
         if(grueCfg.get_doInfills()) {
-            optimizer->addPaths(infillPaths, PathLabel(PathLabel::TYP_INFILL, 
+            optimizer.addPaths(infillPaths, PathLabel(PathLabel::TYP_INFILL, 
                     PathLabel::OWN_MODEL, 
                     LayerPaths::Layer::ExtruderLayer::INFILL_LABEL_VALUE));
         }
 		
-		optimizer->optimize(preoptimized);
+		optimizer.optimize(preoptimized);
 		
-		optimizer->clearBoundaries();
-		optimizer->clearPaths();
+		optimizer.clearBoundaries();
+		optimizer.clearPaths();
 		
         if(grueCfg.get_doRaft() || grueCfg.get_doSupport()) {
             LoopList outsetSupportLoops;
-            loopsOffset(outsetSupportLoops, layerRegions->supportLoops, 
+            loopsOffset(outsetSupportLoops, layerRegions.supportLoops, 
                     0.01);
-            optimizer->addBoundaries(outsetSupportLoops);
+            optimizer.addBoundaries(outsetSupportLoops);
 
-            optimizer->addPaths(supportPaths, PathLabel(PathLabel::TYP_INFILL, 
+            optimizer.addPaths(supportPaths, PathLabel(PathLabel::TYP_INFILL, 
                     PathLabel::OWN_SUPPORT, 0));
 
 
-            optimizer->optimize(presupport); 
+            optimizer.optimize(presupport); 
         }
 		
         extruderlayer.paths.insert(extruderlayer.paths.end(), 
@@ -220,16 +292,10 @@ void Pather::generatePaths(const GrueConfig& grueCfg,
         extruderlayer.paths.insert(extruderlayer.paths.end(), 
                 presupport.begin(), presupport.end());
 		//directionalCoarsenessCleanup(extruderlayer.paths);
-
-//		cout << currentSlice << ": \t" << layerMeasure.getLayerPosition(
-//				layerRegions->layerMeasureId) << endl;
-        }catch (const std::exception& our) {
-            std::cout << "Error " << our.what() << " on layer " << 
-                    currentSlice << std::endl;
-        }
-		++currentSlice;
+	} catch (const std::exception& our) {
+		std::cout << "Error " << our.what() << " on layer " << 
+				currentSlice << std::endl;
 	}
-    delete optimizer;
 }
 
 void Pather::outlines(const LoopList& outline_loops,
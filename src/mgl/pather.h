@@ -21,8 +21,14 @@
 
 #include <list>
 
+#ifdef OMPFF
+#include <omp.h>
+#endif
+
 namespace mgl {
 
+class abstract_optimizer;
+
 class PatherConfig {
 public:
 	PatherConfig() 
@@ -164,12 +170,21 @@ class Pather : public Progressive
 {
 private:
 	PatherConfig patherCfg;
+	bool pathDirection;	//infill direction of the last layer pathed
+	abstract_optimizer* pathOptimizer;	//carried between layers
+
+	Pather(const Pather&);
+	Pather& operator=(const Pather&);
+
+	/// Set the infill direction for layer @a currentSlice
+	void advanceDirection(const GrueConfig& grueCfg, size_t currentSlice);
 
 public:
 
 
 	Pather(const PatherConfig& pCfg, ProgressBar * progress = NULL);
     Pather(const GrueConfig& grueConf, ProgressBar* progress = NULL);
+	~Pather();
 
 
 	void generatePaths(const GrueConfig& grueCfg,
@@ -180,6 +195,30 @@ public:
 					   int sfirstSliceIdx=-1,
 					   int slastSliceIdx=-1);
 
+	/// Start pathing the layers [@a first, @a last) a block at a time.
+	void beginPaths(size_t first, size_t last);
+	/// Path the layers [@a first, @a last) of @a skeleton onto the end of 
+	/// @a layerpaths. The infill direction and the optimizer are kept 
+	/// from one call to the next, so a model pathed block by block after 
+	/// beginPaths gets the same paths as from generatePaths.
+	void appendPaths(const GrueConfig& grueCfg,
+					 const RegionList &skeleton,
+					 const LayerMeasure &layerMeasure,
+					 const Grid &grid,
+					 LayerPaths &layerpaths,
+					 size_t first,
+					 size_t last);
+
+
+	/// Optimize the paths of a single layer into @a extruderlayer, 
+	/// using @a direction for the infill.
+	void layerPaths(const GrueConfig& grueCfg, 
+					const LayerRegions& layerRegions, 
+					const Grid& grid, 
+					bool direction, 
+					abstract_optimizer& optimizer, 
+					LayerPaths::Layer::ExtruderLayer& extruderlayer, 
+					unsigned int currentSlice);
 
 	void outlines(const LoopList& outline_loops,
 				  LoopPathList &boundary_paths);
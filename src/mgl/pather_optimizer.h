@@ -20,6 +20,7 @@ namespace mgl {
 class abstract_optimizer {
 public:
     abstract_optimizer(bool j = true) : jsonErrors(j) {}
+    virtual ~abstract_optimizer() {}
 	typedef std::list<LabeledOpenPath> LabeledOpenPaths;
 	//optimize everything you have accumulated
 	//calls to the internal optimize
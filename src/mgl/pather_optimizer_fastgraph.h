@@ -12,6 +12,7 @@
 #include "simple_topology.h"
 #include "predicate.h"
 #include "basic_boxlist.h"
+#include "basic_strtree.h"
 #include "intersection_index.h"
 #include "Exception.h"
 #include "configuration.h"
@@ -19,6 +20,8 @@
 #include "mgl.h"
 #include <iostream>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace mgl {
 
@@ -145,7 +148,12 @@ FASTGRAPH_PRIVATE:
         bool m_isentry;
     };
     
+    //boundaries are filled once per bucket, then probed by every link
+#ifdef FASTGRAPH_BOXLIST_BOUNDARIES
     typedef basic_boxlist<Segment2Type> boundary_container;
+#else
+    typedef basic_strtree<Segment2Type> boundary_container;
+#endif
     typedef topo::simple_graph<NodeData, Cost> graph_type;
     typedef graph_type::node node;
     typedef graph_type::node_index node_index;
@@ -452,6 +460,73 @@ FASTGRAPH_PRIVATE:
     static entry_iterator entryBegin(graph_type& graph);
     /// get the entry_iterator for graph
     static entry_iterator entryEnd(graph_type& graph);
+
+    /**
+     @brief Spacial index over the entry nodes of a graph.
+     
+     Entries are grouped by label, best label first, and each group keeps 
+     its nodes in a uniform grid. Queries walk groups in label order and 
+     cells in growing rings around the query point, so they return 
+     the same nodes as a full scan ordered by label, distance and node 
+     index, without looking at far away entries. 
+     Nodes must be erased from the index before the graph destroys them.
+     */
+    class entry_index {
+    public:
+        entry_index(graph_type& graph);
+        /** 
+         @brief false when two labels with the same value differ in 
+         type, which the label comparators can not order consistently. 
+         Callers should then fall back to scanning the graph.
+         */
+        bool valid() const { return m_valid; }
+        /// stop considering this node, call before destroying it
+        void erase(node& entry);
+        /**
+         @brief the entry std::min_element would pick with nodeComparator
+         @param point distances are measured from here
+         @param result set to the chosen node
+         @return false if no entries remain
+         */
+        bool best(const Point2Type& point, node_index& result) const;
+        /**
+         @brief connect @a from to the first entry, in probeCompare 
+         order, that can be reached without crossing @a boundaries. 
+         Same rules as buildLinks on sorted probes.
+         */
+        void buildLinks(node& from, boundary_container& boundaries) const;
+    private:
+        class cursor;
+        class group {
+        public:
+            group() : m_inset(false), m_count(0), m_columns(0), m_rows(0), 
+                    m_cellSize(1) {}
+            void build(const std::vector<node_index>& members, 
+                    graph_type& graph);
+            size_t cellOf(const Point2Type& point) const;
+            bool m_inset;
+            size_t m_count;
+            Point2Type m_origin;
+            size_t m_columns;
+            size_t m_rows;
+            Scalar m_cellSize;
+            std::vector<std::vector<node_index> > m_cells;
+        };
+        typedef std::pair<int, int> group_key;
+        typedef std::map<group_key, group> group_map;
+        static group_key keyOf(const PathLabel& label);
+        
+        graph_type& m_graph;
+        group_map m_groups;
+        bool m_valid;
+    };
+    /**
+     @brief find or construct the best outgoing link from a node, using 
+     @a entries instead of scanning the graph
+     */
+    static node::forward_link_iterator bestLink(node& from, graph_type& graph, 
+            boundary_container& boundaries, const entry_index& entries, 
+            const GrueConfig& grueConf, Point2Type unit = Point2Type());
     
     /**
      @brief adapt a predicate for use when building up links
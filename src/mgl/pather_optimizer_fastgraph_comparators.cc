@@ -117,7 +117,10 @@ bool pather_optimizer_fastgraph::probeCompare::operator ()(
     if(nc)
         return nc == BETTER;
     Scalar distDifference = lhs.second - rhs.second;
-    return distDifference < 0;
+    if(distDifference != 0)
+        return distDifference < 0;
+    //equally good and equally far, keep graph order so results are stable
+    return lhs.first < rhs.first;
 }
 
 }
@@ -0,0 +1,255 @@
+#include "pather_optimizer_fastgraph.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace mgl {
+
+/**
+ Visits the entries of one group nearest first. Cells are added a ring at 
+ a time around the cell of the query point; a candidate is only handed 
+ out once every cell that could hold something closer has been added. 
+ Ties in distance come out in node index order.
+ */
+class pather_optimizer_fastgraph::entry_index::cursor {
+public:
+    cursor(const group& grp, graph_type& graph, const Point2Type& point, 
+            bool squared, node_index skip) 
+            : m_group(grp), m_graph(graph), m_point(point), 
+            m_squared(squared), m_skip(skip) {
+        Scalar cx = std::floor((point.x - grp.m_origin.x) / grp.m_cellSize);
+        Scalar cy = std::floor((point.y - grp.m_origin.y) / grp.m_cellSize);
+        //keep far away points from overflowing the ring arithmetic
+        Scalar far = Scalar(grp.m_columns + grp.m_rows + 1);
+        m_column = (long long)std::max(-far, std::min(far, cx));
+        m_row = (long long)std::max(-far, std::min(far, cy));
+        long long lastColumn = (long long)grp.m_columns - 1;
+        long long lastRow = (long long)grp.m_rows - 1;
+        m_ring = std::max(std::max(-m_column, m_column - lastColumn), 
+                std::max(-m_row, m_row - lastRow));
+        m_ring = std::max(m_ring, 0LL);
+        m_lastRing = std::max(std::max(m_column, lastColumn - m_column), 
+                std::max(m_row, lastRow - m_row));
+        if(!grp.m_count)
+            m_ring = m_lastRing + 1;
+    }
+    bool next(node_index& result, Scalar& distance) {
+        while(true) {
+            if(!m_candidates.empty() && (m_ring > m_lastRing || 
+                    m_candidates.top().first < bound())) {
+                distance = m_candidates.top().first;
+                result = m_candidates.top().second;
+                m_candidates.pop();
+                return true;
+            }
+            if(m_ring > m_lastRing)
+                return false;
+            addRing(m_ring++);
+        }
+    }
+private:
+    typedef std::pair<Scalar, node_index> candidate;
+    /// lower limit on the distance of anything in rings not yet added
+    Scalar bound() const {
+        //rings start at the query cell, so ring r is at least r - 1 
+        //cells away. Shave a little off for rounding in the cell lookup
+        Scalar cells = Scalar(m_ring - 1);
+        if(cells <= 0)
+            return -1;
+        Scalar linear = cells * m_group.m_cellSize * (1.0 - 1e-9);
+        return m_squared ? linear * linear : linear;
+    }
+    void addCell(long long column, long long row) {
+        if(column < 0 || row < 0 || column >= (long long)m_group.m_columns || 
+                row >= (long long)m_group.m_rows)
+            return;
+        const std::vector<node_index>& cell = 
+                m_group.m_cells[row * m_group.m_columns + column];
+        for(std::vector<node_index>::const_iterator iter = cell.begin(); 
+                iter != cell.end(); 
+                ++iter) {
+            if(*iter == m_skip)
+                continue;
+            const Point2Type& position = m_graph[*iter].data().getPosition();
+            //same expressions as nodeComparator and buildLinks use
+            Scalar distance = m_squared ? 
+                    (position - m_point).squaredMagnitude() : 
+                    (m_point - position).magnitude();
+            m_candidates.push(candidate(distance, *iter));
+        }
+    }
+    void addRing(long long ring) {
+        if(ring == 0) {
+            addCell(m_column, m_row);
+            return;
+        }
+        for(long long column = m_column - ring; 
+                column <= m_column + ring; 
+                ++column) {
+            addCell(column, m_row - ring);
+            addCell(column, m_row + ring);
+        }
+        for(long long row = m_row - ring + 1; 
+                row <= m_row + ring - 1; 
+                ++row) {
+            addCell(m_column - ring, row);
+            addCell(m_column + ring, row);
+        }
+    }
+    
+    const group& m_group;
+    graph_type& m_graph;
+    Point2Type m_point;
+    bool m_squared;
+    node_index m_skip;
+    long long m_column;
+    long long m_row;
+    long long m_ring;
+    long long m_lastRing;
+    std::priority_queue<candidate, std::vector<candidate>, 
+            std::greater<candidate> > m_candidates;
+};
+
+pather_optimizer_fastgraph::entry_index::entry_index(graph_type& graph) 
+        : m_graph(graph), m_valid(true) {
+    std::map<group_key, std::vector<node_index> > members;
+    std::map<int, bool> valueIsInset;
+    for(entry_iterator iter = entryBegin(graph); 
+            iter != entryEnd(graph); 
+            ++iter) {
+        const PathLabel& label = iter->data().getLabel();
+        const Point2Type& position = iter->data().getPosition();
+        std::map<int, bool>::iterator known = 
+                valueIsInset.find(label.myValue);
+        if((known != valueIsInset.end() && 
+                known->second != label.isInset()) || 
+                !(std::fabs(position.x) < std::numeric_limits<Scalar>::max()) || 
+                !(std::fabs(position.y) < std::numeric_limits<Scalar>::max())) {
+            m_valid = false;
+            return;
+        }
+        valueIsInset[label.myValue] = label.isInset();
+        members[keyOf(label)].push_back(iter->getIndex());
+    }
+    for(std::map<group_key, std::vector<node_index> >::const_iterator iter = 
+            members.begin(); 
+            iter != members.end(); 
+            ++iter) {
+        group& created = m_groups[iter->first];
+        created.m_inset = iter->first.first == 0;
+        created.build(iter->second, graph);
+    }
+}
+pather_optimizer_fastgraph::entry_index::group_key 
+        pather_optimizer_fastgraph::entry_index::keyOf(const PathLabel& label) {
+    //insets first, then higher values first, as LabelComparator orders them
+    return group_key(label.isInset() ? 0 : 1, -label.myValue);
+}
+void pather_optimizer_fastgraph::entry_index::group::build(
+        const std::vector<node_index>& members, graph_type& graph) {
+    m_count = members.size();
+    Point2Type low = graph[members.front()].data().getPosition();
+    Point2Type high = low;
+    for(std::vector<node_index>::const_iterator iter = members.begin(); 
+            iter != members.end(); 
+            ++iter) {
+        const Point2Type& position = graph[*iter].data().getPosition();
+        low.x = std::min(low.x, position.x);
+        low.y = std::min(low.y, position.y);
+        high.x = std::max(high.x, position.x);
+        high.y = std::max(high.y, position.y);
+    }
+    Scalar width = high.x - low.x;
+    Scalar height = high.y - low.y;
+    //about one entry per cell, and never more than count cells on a side
+    m_cellSize = std::max(std::sqrt(width * height / m_count), 
+            std::max(width, height) / m_count);
+    if(!(m_cellSize > 0))
+        m_cellSize = 1;
+    m_origin = low;
+    m_columns = size_t(width / m_cellSize) + 1;
+    m_rows = size_t(height / m_cellSize) + 1;
+    m_cells.assign(m_columns * m_rows, std::vector<node_index>());
+    for(std::vector<node_index>::const_iterator iter = members.begin(); 
+            iter != members.end(); 
+            ++iter) {
+        m_cells[cellOf(graph[*iter].data().getPosition())].push_back(*iter);
+    }
+}
+size_t pather_optimizer_fastgraph::entry_index::group::cellOf(
+        const Point2Type& point) const {
+    Scalar column = std::floor((point.x - m_origin.x) / m_cellSize);
+    Scalar row = std::floor((point.y - m_origin.y) / m_cellSize);
+    size_t c = column < 0 ? 0 : std::min(size_t(column), m_columns - 1);
+    size_t r = row < 0 ? 0 : std::min(size_t(row), m_rows - 1);
+    return r * m_columns + c;
+}
+void pather_optimizer_fastgraph::entry_index::erase(node& entry) {
+    if(!m_valid || !entry.data().isEntry())
+        return;
+    group_map::iterator found = m_groups.find(keyOf(entry.data().getLabel()));
+    if(found == m_groups.end())
+        return;
+    group& owner = found->second;
+    std::vector<node_index>& cell = 
+            owner.m_cells[owner.cellOf(entry.data().getPosition())];
+    std::vector<node_index>::iterator member = 
+            std::find(cell.begin(), cell.end(), entry.getIndex());
+    if(member == cell.end())
+        return;
+    *member = cell.back();
+    cell.pop_back();
+    --owner.m_count;
+}
+bool pather_optimizer_fastgraph::entry_index::best(const Point2Type& point, 
+        node_index& result) const {
+    for(group_map::const_iterator iter = m_groups.begin(); 
+            iter != m_groups.end(); 
+            ++iter) {
+        if(!iter->second.m_count)
+            continue;
+        cursor nearest(iter->second, m_graph, point, true, node_index(-1));
+        Scalar distance;
+        return nearest.next(result, distance);
+    }
+    return false;
+}
+void pather_optimizer_fastgraph::entry_index::buildLinks(node& from, 
+        boundary_container& boundaries) const {
+    const Point2Type origin = from.data().getPosition();
+    bool haveFront = false;
+    bool frontInset = false;
+    for(group_map::const_iterator iter = m_groups.begin(); 
+            iter != m_groups.end(); 
+            ++iter) {
+        if(haveFront && frontInset && !iter->second.m_inset)
+            break;  //make no connections to things of lower priority
+        cursor nearest(iter->second, m_graph, origin, false, from.getIndex());
+        node_index candidate;
+        Scalar distance;
+        while(nearest.next(candidate, distance)) {
+            if(!haveFront) {
+                haveFront = true;
+                frontInset = iter->second.m_inset;
+            }
+            node& to = m_graph[candidate];
+            Segment2Type probeline(origin, to.data().getPosition());
+            Point2Type unit;
+            try {
+                unit = (to.data().getPosition() - origin).unit();
+            } catch (const GeometryException& le) {}
+            if(!crossesBounds(probeline, boundaries)) {
+                from.connect(to, Cost(PathLabel(PathLabel::TYP_CONNECTION, 
+                        PathLabel::OWN_MODEL, -1), 
+                        distance, 
+                        unit));
+                return;
+            }
+        }
+    }
+}
+
+}
@@ -7,19 +7,19 @@
 
 namespace mgl {
 
+class SegmentCrossing {
+public:
+    SegmentCrossing(const Segment2Type& line) : m_line(line) {}
+    bool operator()(const Segment2Type& other) const {
+        return other.intersects(m_line);
+    }
+private:
+    const Segment2Type& m_line;
+};
 bool pather_optimizer_fastgraph::crossesBounds(
         const Segment2Type& line, 
         boundary_container& boundaries) {
-    std::vector<Segment2Type> filtered;
-    boundaries.search(filtered, LineSegmentFilter(line));
-    for(std::vector<Segment2Type>::const_iterator iter = 
-            filtered.begin(); 
-            iter != filtered.end(); 
-            ++iter) {
-        if(iter->intersects(line))
-            return true;
-    }
-    return false;
+    return boundaries.any(LineSegmentFilter(line), SegmentCrossing(line));
 }
 pather_optimizer_fastgraph::node::forward_link_iterator
         pather_optimizer_fastgraph::bestLink(node& from, 
@@ -33,6 +33,20 @@ pather_optimizer_fastgraph::node::forward_link_iterator
     return std::min_element(from.forwardBegin(), 
             from.forwardEnd(), NodeConnectionComparator(grueConf, unit));
 }
+pather_optimizer_fastgraph::node::forward_link_iterator
+        pather_optimizer_fastgraph::bestLink(node& from, 
+        graph_type& graph, boundary_container& boundaries, 
+        const entry_index& entries, const GrueConfig& grueConf, 
+        Point2Type unit) {
+    if(from.forwardEmpty()) {
+        if(entries.valid())
+            entries.buildLinks(from, boundaries);
+        else
+            buildLinks(from, graph, boundaries, grueConf);
+    }
+    return std::min_element(from.forwardBegin(), 
+            from.forwardEnd(), NodeConnectionComparator(grueConf, unit));
+}
 pather_optimizer_fastgraph::node::forward_link_iterator
         pather_optimizer_fastgraph::bestLink(node& from, 
         graph_type& graph, boundary_container& boundaries, 
@@ -279,10 +293,14 @@ void pather_optimizer_fastgraph::optimizeGraph(
     boundary_container& currentBounds = bounds;
     LabeledOpenPaths& output = labeledpaths;
     
+    entry_index entries(currentGraph);
+    
     while(!currentGraph.empty()) {
-        currentIndex = std::min_element(entryBegin(currentGraph), 
-                entryEnd(currentGraph), 
-                nodeComparator(grueConf, currentGraph, entryPoint))->getIndex();
+        if(!entries.valid() || !entries.best(entryPoint, currentIndex)) {
+            currentIndex = std::min_element(entryBegin(currentGraph), 
+                    entryEnd(currentGraph), 
+                    nodeComparator(grueConf, currentGraph, entryPoint))->getIndex();
+        }
         LabeledOpenPath activePath;
         if(!currentGraph[currentIndex].forwardEmpty()) {
             //can a connection be made from the last entry to here?
@@ -299,7 +317,8 @@ void pather_optimizer_fastgraph::optimizeGraph(
                     output, activePath, entryPoint);
         }
         while((next = bestLink(currentGraph[currentIndex], 
-                currentGraph, currentBounds, grueConf, currentUnit)) != 
+                currentGraph, currentBounds, entries, grueConf, 
+                currentUnit)) != 
                 currentGraph[currentIndex].forwardEnd()) {
             node::connection nextConnection = *next;
             currentUnit = nextConnection.second->normal();
@@ -310,12 +329,14 @@ void pather_optimizer_fastgraph::optimizeGraph(
             nextConnection.first->disconnect(currentGraph[currentIndex]);
             if(currentGraph[currentIndex].forwardEmpty() && 
                     currentGraph[currentIndex].reverseEmpty()) {
+                entries.erase(currentGraph[currentIndex]);
                 currentGraph.destroyNode(currentGraph[currentIndex]);
             }
             currentIndex = nextConnection.first->getIndex();
         }
         if(currentGraph[currentIndex].forwardEmpty() && 
                 currentGraph[currentIndex].reverseEmpty()) {
+            entries.erase(currentGraph[currentIndex]);
             currentGraph.destroyNode(currentGraph[currentIndex]);
         }
         //recover from corners here
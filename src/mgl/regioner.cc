@@ -21,10 +21,21 @@ using namespace libthing;
 
 
 Regioner::Regioner(const GrueConfig& grueConf, ProgressBar* progress)
-        : Progressive(progress), grueCfg(grueConf) {}
+        : Progressive(progress), grueCfg(grueConf), firstModelLayer(0), 
+        outlinedLayers(0), infilledLayers(0), releasedLayers(0) {}
 
 static const Scalar LOOP_ERROR_FUDGE_FACTOR = 0.05;
-
+/// layers per block of the support scan
+static const size_t SUPPORT_BLOCK_LAYERS = 16;
+
+/*
+ The per layer stages below only read the neighbouring layers produced by 
+ an earlier stage, so generateSkeleton running them one after the other is 
+ what orders the dependencies (insets before spurs and roofing/flooring, 
+ roofing/flooring before infills). Within a stage, layers are independent 
+ and are spread across threads in multi_thread builds. Every layer writes 
+ only to its own LayerRegions, so the result does not depend on scheduling.
+ */
 void Regioner::generateSkeleton(const LayerLoops& layerloops,
 		LayerMeasure& layerMeasure,
 		RegionList& regionlist,
@@ -48,26 +59,7 @@ void Regioner::generateSkeleton(const LayerLoops& layerloops,
 		support(firstmodellayer, regionlist.end(), layerMeasure);
 	}
 
-	//optionally inflate if rafts present
-	if (grueCfg.get_doRaft() && grueCfg.get_raftLayers() > 0) {
-        Scalar raftHeight = grueCfg.get_raftBaseThickness() + 
-                grueCfg.get_raftInterfaceThickness() * 
-                (grueCfg.get_raftLayers() - 1);
-        Scalar raftOutsetOverhead = grueCfg.get_raftOutset() * 4;
-        //increase height by raft height
-        limits.grow(Point3Type(
-                limits.center().x, limits.center().y, 
-                limits.zMax + raftHeight));
-        //grow sides by raft outset
-        limits.inflate(raftOutsetOverhead, raftOutsetOverhead, 0);
-	}
-    if(grueCfg.get_doSupport()) {
-        Scalar supportOverhead = grueCfg.get_supportMargin() * 4;
-        limits.inflate(supportOverhead, supportOverhead, 0);
-    }
-
-	grid.init(limits, layerMeasure.getLayerW() *
-			grueCfg.get_gridSpacingMultiplier());
+	initGrid(layerMeasure, limits, grid);
 
 	if (grueCfg.get_doRaft()) {
 		initProgress("rafts", grueCfg.get_raftLayers() + 4);
@@ -101,6 +93,162 @@ void Regioner::generateSkeleton(const LayerLoops& layerloops,
 	infills(regionlist.begin(), regionlist.end(), grid);
 }
 
+void Regioner::initGrid(const LayerMeasure& layerMeasure, 
+		Limits& limits, 
+		Grid& grid) {
+	//optionally inflate if rafts present
+	if (grueCfg.get_doRaft() && grueCfg.get_raftLayers() > 0) {
+        Scalar raftHeight = grueCfg.get_raftBaseThickness() + 
+                grueCfg.get_raftInterfaceThickness() * 
+                (grueCfg.get_raftLayers() - 1);
+        Scalar raftOutsetOverhead = grueCfg.get_raftOutset() * 4;
+        //increase height by raft height
+        limits.grow(Point3Type(
+                limits.center().x, limits.center().y, 
+                limits.zMax + raftHeight));
+        //grow sides by raft outset
+        limits.inflate(raftOutsetOverhead, raftOutsetOverhead, 0);
+	}
+    if(grueCfg.get_doSupport()) {
+        Scalar supportOverhead = grueCfg.get_supportMargin() * 4;
+        limits.inflate(supportOverhead, supportOverhead, 0);
+    }
+
+	grid.init(limits, layerMeasure.getLayerW() *
+			grueCfg.get_gridSpacingMultiplier());
+}
+
+/**
+ @brief The part of the interior of @a current that @a neighbour, the 
+ layer above or below, does not cover, as a roof or floor of @a current.
+ */
+static void exposedRegion(const LayerRegions& current, 
+		const LayerRegions& neighbour, 
+		ClipperRegion& exposed) {
+	ClipperRegion diffResult;
+	if(!neighbour.insetLoops.empty()) {
+		regionsDifference(diffResult, current.interiorRegion, 
+				neighbour.innerInsetRegion);
+	}
+	//compensate for errors in the difference by a fudge factor
+	regionsOffset(exposed, diffResult, LOOP_ERROR_FUDGE_FACTOR);
+}
+
+/**
+ @brief Where the floors and roofs read by infills of layers from 
+ @a first on start. Window unions are built over blocks counted from the 
+ first layer, so these are the starts of the blocks the windows of 
+ @a first fall in.
+ */
+static void solidWindowStarts(size_t first, 
+		size_t floorCount, size_t roofCount, 
+		size_t& floorStart, size_t& roofStart) {
+	size_t floorBlock = std::max(floorCount, size_t(1));
+	size_t roofBlock = std::max(roofCount, size_t(1));
+	floorStart = first + 1 > floorBlock ? first + 1 - floorBlock : 0;
+	floorStart -= floorStart % floorBlock;
+	roofStart = first - first % roofBlock;
+}
+
+void Regioner::beginSkeleton(const LayerLoops& layerloops,
+		LayerMeasure& layerMeasure,
+		RegionList& regionlist,
+		Limits& limits,
+		Grid& grid) {
+	if (grueCfg.get_doSupport()) {
+		throw Exception(
+				"Support can't be regioned a window of layers at a time");
+	}
+	layerMeasure.setLayerWidthRatio(grueCfg.get_layerWidthRatio());
+	RegionList::iterator firstmodellayer;
+	initRegionList(layerloops, regionlist, layerMeasure, firstmodellayer);
+	roofLengthCutOff = 0.5 * layerMeasure.getLayerW();
+	initGrid(layerMeasure, limits, grid);
+
+	firstModelLayer = firstmodellayer - regionlist.begin();
+	outlinedLayers = firstModelLayer;
+	infilledLayers = 0;
+	releasedLayers = 0;
+}
+
+size_t Regioner::appendSkeleton(LayerLoops::const_layer_iterator outlinesBegin,
+		LayerLoops::const_layer_iterator outlinesEnd,
+		LayerMeasure& layerMeasure,
+		RegionList& regionlist,
+		const Grid& grid) {
+	size_t layerCount = regionlist.size();
+	size_t first = outlinedLayers;
+	for (LayerLoops::const_layer_iterator outline = outlinesBegin; 
+			outline != outlinesEnd && outlinedLayers < layerCount; 
+			++outline) {
+		regionlist[outlinedLayers++].outlines = outline->readLoops();
+	}
+	size_t last = outlinedLayers;
+	RegionList::iterator regions = regionlist.begin();
+
+	//rafts only need the bottom layer of the model
+	if (first == firstModelLayer && last > first) {
+		if (grueCfg.get_doRaft())
+			rafts(regionlist[firstModelLayer], layerMeasure, regionlist);
+		flatSurfaces(regions, regions + firstModelLayer, grid);
+	}
+
+	insets(outlinesBegin, outlinesEnd, regions + first, regions + last, 
+			layerMeasure);
+	spurs(regions + first, regions + last, layerMeasure);
+	flatSurfaces(regions + first, regions + last, grid);
+
+	//the roof of the layer below the new ones waited for them
+	size_t roofBegin = first > firstModelLayer ? first - 1 : first;
+	int surfaceCount = last - roofBegin;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < surfaceCount; ++i) {
+		size_t layer = roofBegin + i;
+		LayerRegions& current = regionlist[layer];
+		if (layer + 1 < last)
+			exposedRegion(current, regionlist[layer + 1], current.roofRegion);
+		if (layer == firstModelLayer)
+			current.floorRegion = current.interiorRegion;
+		else if (layer >= first)
+			exposedRegion(current, regionlist[layer - 1], current.floorRegion);
+	}
+	if (last == layerCount && last > first)
+		regionlist.back().roofing = regionlist.back().flatSurface;
+
+	//solid infill reads the roofs of roofCount - 1 layers above
+	size_t roofCount = grueCfg.get_roofLayerCount();
+	size_t floorCount = grueCfg.get_floorLayerCount();
+	size_t infillEnd = last;
+	if (last < layerCount)
+		infillEnd = last > roofCount ? last - roofCount : 0;
+	if (infillEnd > infilledLayers) {
+		infills(regions, regionlist.end(), infilledLayers, infillEnd, grid);
+		infilledLayers = infillEnd;
+	}
+
+	//keep what later calls read: the floors and roofs later infills 
+	//rebuild their windows from, and the insets of the top layer
+	size_t kept = infilledLayers;
+	if (last < layerCount) {
+		size_t floorStart, roofStart;
+		solidWindowStarts(infilledLayers, floorCount, roofCount, 
+				floorStart, roofStart);
+		kept = std::min(std::min(kept, floorStart), roofStart);
+		kept = std::min(kept, last > 0 ? last - 1 : 0);
+	}
+	for (; releasedLayers < kept; ++releasedLayers) {
+		LayerRegions& released = regionlist[releasedLayers];
+		released.innerInsetRegion.clear();
+		released.interiorRegion.clear();
+		released.floorRegion.clear();
+		released.roofRegion.clear();
+	}
+	return kept;
+}
+
 size_t Regioner::initRegionList(const LayerLoops& layerloops,
 		RegionList &regionlist,
 		LayerMeasure& layermeasure,
@@ -260,20 +408,33 @@ void Regioner::insetsForSlice(const LoopList& sliceOutlines,
 							  LoopList &interiors) {
 	const Scalar base_distance = 0.5 * layermeasure.getLayerW();
 
-	for (unsigned int shell = 0; shell < grueCfg.get_nbOfShells(); ++shell) {
-		sliceInsets.push_back(LoopList());
-		LoopList &shells = sliceInsets.back();
+	ClipperRegion innermost;
+	insetsForSlice(ClipperRegion(sliceOutlines), layermeasure, sliceInsets, 
+				   innermost);
+
+	// calculate the interior of a loop, temporarily hardcode the distance to
+	// half layerW
+	ClipperRegion interiorRegion;
+	regionsOffset(interiorRegion, innermost, -base_distance);
+	interiorRegion.toLoops(interiors);
+}
+
+void Regioner::insetsForSlice(const ClipperRegion& sliceOutlines,
+							  const LayerMeasure& layermeasure,
+							  std::list<LoopList>& sliceInsets,
+							  ClipperRegion &innermost) {
+	const Scalar base_distance = 0.5 * layermeasure.getLayerW();
 
+	innermost.clear();
+	for (unsigned int shell = 0; shell < grueCfg.get_nbOfShells(); ++shell) {
 		Scalar distance = base_distance + grueCfg.get_insetDistanceMultiplier()
 			* layermeasure.getLayerW() * shell;
 
-		loopsOffset(shells, sliceOutlines, -distance);
-	}
-
-	// calculate the interior of a loop, temporarily hardcode the distance to
-	// half layerW
+		regionsOffset(innermost, sliceOutlines, -distance);
 
-	loopsOffset(interiors, sliceInsets.back(), -base_distance);
+		sliceInsets.push_back(LoopList());
+		innermost.toLoops(sliceInsets.back());
+	}
 }
 
 
@@ -302,22 +463,35 @@ void Regioner::insets(const LayerLoops::const_layer_iterator outlinesBegin,
 		RegionList::iterator regionsEnd,
 		LayerMeasure& layermeasure) {
 
-	LayerLoops::const_layer_iterator outline = outlinesBegin;
-	RegionList::iterator region = regionsBegin;
-	while (outline != outlinesEnd && region != regionsEnd) {
+	std::vector<const LoopList*> outlines;
+	for (LayerLoops::const_layer_iterator outline = outlinesBegin; 
+			outline != outlinesEnd && 
+			regionsBegin + outlines.size() != regionsEnd; 
+			++outline) {
+		outlines.push_back(&outline->readLoops());
+	}
+	int layerCount = outlines.size();
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < layerCount; ++i) {
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
 		tick();
-		const LoopList& currentOutlines = outline->readLoops();
+		RegionList::iterator region = regionsBegin + i;
+		const LoopList& currentOutlines = *outlines[i];
 
-		insetsForSlice(currentOutlines, layermeasure, region->insetLoops, 
-					   region->interiorLoops);
+		insetsForSlice(ClipperRegion(currentOutlines), layermeasure, 
+					   region->insetLoops, region->innerInsetRegion);
 
         if(!region->insetLoops.empty()) {
-            loopsOffset(region->interiorLoops, region->insetLoops.back(), 
+            regionsOffset(region->interiorRegion, region->innerInsetRegion, 
                     -grueCfg.get_infillShellSpacingMultiplier() * 
                     layermeasure.getLayerWidth(region->layerMeasureId));
         }
-		++outline;
-		++region;
+        region->interiorRegion.toLoops(region->interiorLoops);
 	}
 
     tick();
@@ -326,20 +500,23 @@ void Regioner::insets(const LayerLoops::const_layer_iterator outlinesBegin,
 void Regioner::flatSurfaces(RegionList::iterator regionsBegin,
 		RegionList::iterator regionsEnd,
 		const Grid& grid) {
-	for (; regionsBegin != regionsEnd; ++regionsBegin) {
+	int layerCount = regionsEnd - regionsBegin;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < layerCount; ++i) {
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
 		tick();
+		RegionList::iterator region = regionsBegin + i;
 		//GridRanges currentSurface;
 
-//		gridRangesForSlice(regionsBegin->insetLoops, grid,
-//				regionsBegin->flatSurface);
-        regionsBegin->flatSurface.yRays.resize(grid.getXValues().size());
-        regionsBegin->flatSurface.xRays.resize(grid.getYValues().size());
-		//inset supportloops by a fraction of supportmargin
-		LoopList insetSupportLoops;
-		loopsOffset(insetSupportLoops, regionsBegin->supportLoops, 
-				-0.01);
-		gridRangesForSlice(insetSupportLoops, grid,
-				regionsBegin->supportSurface);
+//		gridRangesForSlice(region->insetLoops, grid,
+//				region->flatSurface);
+        region->flatSurface.yRays.resize(grid.getXValues().size());
+        region->flatSurface.xRays.resize(grid.getYValues().size());
 	}
 }
 
@@ -364,35 +541,32 @@ void Regioner::roofing(RegionList::iterator regionsBegin,
         ) {
     if(regionsBegin == regionsEnd)
         return;
-	RegionList::iterator current = regionsBegin;
-	RegionList::iterator above = current;
-	++above;
-
-	while (above != regionsEnd) {
+    int layerCount = regionsEnd - regionsBegin;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < layerCount - 1; ++i) {
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
 		tick();
+		RegionList::iterator current = regionsBegin + i;
+		RegionList::iterator above = current + 1;
 //		const GridRanges & currentSurface = current->flatSurface;
 //		const GridRanges & surfaceAbove = above->flatSurface;
 //		GridRanges & roofing = current->roofing;
-        LoopList& roofLoops = current->roofLoops;
 
 //		GridRanges roof;
 //		roofForSlice(currentSurface, surfaceAbove, grid, roof);
 //
 //		grid.trimGridRange(roof, roofLengthCutOff, roofing);
-        LoopList diffResult;
-        if(!above->insetLoops.empty()) {
-            loopsDifference(diffResult, current->interiorLoops, 
-                    above->insetLoops.back());
-        }
-        //compensate for errors in the difference by a fudge factor
-        loopsOffset(roofLoops, diffResult, LOOP_ERROR_FUDGE_FACTOR);
-
-		++current;
-		++above;
+        exposedRegion(*current, *above, current->roofRegion);
 	}
 
 	tick();
-	current->roofing = current->flatSurface;
+	RegionList::iterator top = regionsEnd - 1;
+	top->roofing = top->flatSurface;
 }
 
 void Regioner::flooring(RegionList::iterator regionsBegin,
@@ -401,231 +575,276 @@ void Regioner::flooring(RegionList::iterator regionsBegin,
         ) {
     if(regionsBegin == regionsEnd)
         return;
-	RegionList::iterator below = regionsBegin;
-	RegionList::iterator current = below;
-	current++;
-
-	while (current != regionsEnd) {
-        LoopList& floorLoops = current->floorLoops;
+    int layerCount = regionsEnd - regionsBegin;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 1; i < layerCount; ++i) {
+		RegionList::iterator below = regionsBegin + (i - 1);
+		RegionList::iterator current = regionsBegin + i;
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
 		tick();
 //		const GridRanges & currentSurface = current->flatSurface;
 //		const GridRanges & surfaceBelow = below->flatSurface;
 //		GridRanges & flooring = current->flooring;
 
 //		floorForSlice(currentSurface, surfaceBelow, grid, flooring);
-        LoopList diffResult;
-        if(!below->insetLoops.empty()) {
-            loopsDifference(diffResult, current->interiorLoops, 
-                    below->insetLoops.back());
-        }
-        //compensate for errors in the difference by a fudge factor
-        loopsOffset(floorLoops, diffResult, LOOP_ERROR_FUDGE_FACTOR);
-
-		++below;
-		++current;
+        exposedRegion(*current, *below, current->floorRegion);
 	}
 
 	tick();
 //	regionsBegin->flooring = regionsBegin->flatSurface;
-    regionsBegin->floorLoops = regionsBegin->interiorLoops;
+    regionsBegin->floorRegion = regionsBegin->interiorRegion;
 
 }
 
 void Regioner::support(RegionList::iterator regionsBegin,
 		RegionList::iterator regionsEnd, 
 		LayerMeasure& /*layermeasure*/) {
-	std::list<LoopList> marginsList;
-	
-	for(RegionList::const_iterator iter = regionsBegin; 
-			iter != regionsEnd; 
-			++iter) {
-		LoopList currentMargins;
-		loopsOffset(currentMargins, iter->outlines, 
+	int layerCount = regionsEnd - regionsBegin;
+	if (layerCount < 2)
+		return;
+	//margins keep support off the model, their outsets are what each
+	//layer asks of the layers below it
+	std::vector<ClipperRegion> margins(layerCount);
+	std::vector<ClipperRegion> outsets(layerCount);
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < layerCount; ++i) {
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
+		tick();
+		regionsOffset(margins[i], ClipperRegion((regionsBegin + i)->outlines), 
 				grueCfg.get_supportMargin());
-		marginsList.push_back(currentMargins);
+		//offset by a fudge factor to compensate for error when 
+		//margins are subtracted from the layer above
+		regionsOffset(outsets[i], margins[i], LOOP_ERROR_FUDGE_FACTOR);
 	}
-	int layerskip = 1;
-	RegionList::iterator above = regionsEnd;
-	std::list<LoopList>::const_iterator aboveMargins = marginsList.end();
-	--above; //work from the highest layer down
-	--aboveMargins;
-	
-	RegionList::iterator current = above;
-	std::list<LoopList>::const_iterator currentMargins = aboveMargins;
-	
-	while (above != regionsBegin && 
-			aboveMargins != marginsList.end()) {
-		--current;
-		--currentMargins;
-		
-		LoopList &support = current->supportLoops;
-        
-        //offset aboveMargins by a fudge factor
-        //to compensate for error when we subtracted them from layer above
-        LoopList aboveMarginsOutset;
-        loopsOffset(aboveMarginsOutset, *aboveMargins, LOOP_ERROR_FUDGE_FACTOR);
-        
-		if (above->supportLoops.empty()) {
-			//beginning of new support
-			support = aboveMarginsOutset;
-		} else {
-			//start with a projection of support from the layer above
-			support = above->supportLoops;
-			//add the outlines of layer above
-			loopsUnion(support, aboveMarginsOutset);
-		}
-        tick();
-		//subtract current outlines from the support loops to keep support
-		//from overlapping the object
-
-		//use margins computed up front
-		loopsDifference(support, *currentMargins);
 
-		--above;
-		--aboveMargins;
-		tick();
+	/*
+	 Support of a layer is the union of the outsets of all layers above
+	 it less its own margins. Carrying each layer's support down to the 
+	 next gives the same area, because every outset covers the margins 
+	 taken out of its own layer, so only the running union is carried.
+
+	 That union is a suffix scan over the layers. They are cut into 
+	 blocks of fixed length, each block's outsets are unioned in one pass
+	 and the block totals are carried down from the top, after which the
+	 blocks run their own layers independently. The blocks do not depend 
+	 on the number of threads, so neither does the support.
+	 */
+	size_t blockCount = (layerCount + SUPPORT_BLOCK_LAYERS - 1) / 
+			SUPPORT_BLOCK_LAYERS;
+	std::vector<ClipperRegion> carried(blockCount);
+	{
+		std::vector<ClipperRegion> totals(blockCount);
+#ifdef OMPFF
+		#pragma omp parallel for schedule(dynamic) \
+				num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+		for (int block = 0; block < int(blockCount); ++block) {
+			size_t first = block * SUPPORT_BLOCK_LAYERS;
+			size_t last = std::min(first + SUPPORT_BLOCK_LAYERS, 
+					size_t(layerCount));
+			std::vector<const ClipperRegion*> operands;
+			for (size_t i = first; i < last; ++i)
+				operands.push_back(&outsets[i]);
+			regionsUnion(totals[block], operands);
+		}
+		for (size_t block = blockCount - 1; block-- > 0;)
+			regionsUnion(carried[block], carried[block + 1], 
+					totals[block + 1]);
 	}
-	return;
-	current = regionsBegin;
-	currentMargins = marginsList.begin();
-	above = current;
-	aboveMargins = currentMargins;
-	++above;
-	++aboveMargins;
-	
-	while(current != regionsEnd && 
-			currentMargins != marginsList.end()) {
-		int curskip = 0;
-		for(above = current, aboveMargins = currentMargins, 
-				++above, ++aboveMargins; 
-				curskip < layerskip && 
-				above != regionsEnd && 
-				aboveMargins != marginsList.end(); 
-				++above, ++aboveMargins, ++curskip) {
-			loopsDifference(above->supportLoops, *currentMargins);
-			loopsDifference(current->supportLoops, *aboveMargins);
+
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int block = 0; block < int(blockCount); ++block) {
+		size_t first = block * SUPPORT_BLOCK_LAYERS;
+		size_t last = std::min(first + SUPPORT_BLOCK_LAYERS, 
+				size_t(layerCount));
+		ClipperRegion above;
+		above.swap(carried[block]);
+		for (size_t i = last; i-- > first;) {
+#ifdef OMPFF
+			#pragma omp critical (regioner_progress)
+#endif
+			tick();
+			if (!above.empty()) {
+				//the union gains a vertex wherever some layer above 
+				//sticks out past the others, so it is simplified first, 
+				//then the exact margins keep the gap to the model
+				ClipperRegion support;
+				regionsSimplify(support, above, 
+						grueCfg.get_supportTolerance());
+				regionsDifference(support, margins[i]);
+				support.toLoops((regionsBegin + i)->supportLoops);
+			}
+			if (i > first)
+				regionsUnion(above, outsets[i]);
 		}
-		++current;
-		++currentMargins;
-		tick();
 	}
-	
 }
 
 void Regioner::infills(RegionList::iterator regionsBegin,
 		RegionList::iterator regionsEnd,
 		const Grid &grid) {
-    size_t sequenceNumber = 0;
-	for (RegionList::iterator current = regionsBegin;
-			current != regionsEnd; ++current, ++sequenceNumber) {
+	infills(regionsBegin, regionsEnd, 0, regionsEnd - regionsBegin, grid);
+
+	//nothing reads the working regions after this stage
+	for (RegionList::iterator current = regionsBegin; 
+			current != regionsEnd; ++current) {
+		current->innerInsetRegion.clear();
+		current->interiorRegion.clear();
+		current->floorRegion.clear();
+		current->roofRegion.clear();
+	}
+}
+
+void Regioner::infills(RegionList::iterator regionsBegin,
+		RegionList::iterator regionsEnd,
+		size_t first,
+		size_t last,
+		const Grid &grid) {
+	//each layer is solid where a floor up to floorCount - 1 layers below 
+	//or a roof up to roofCount - 1 layers above it is
+	const unsigned int floorCount = grueCfg.get_floorLayerCount();
+	const unsigned int roofCount = grueCfg.get_roofLayerCount();
+	//windows unioned from the start of their blocks to where the last 
+	//one ends are the same as if all layers were unioned
+	size_t floorStart, roofStart;
+	solidWindowStarts(first, floorCount, roofCount, floorStart, roofStart);
+	size_t roofEnd = std::min(last + (roofCount > 0 ? roofCount - 1 : 0), 
+			size_t(regionsEnd - regionsBegin));
+	std::vector<const ClipperRegion*> floors, roofs;
+	if (floorCount > 0) {
+		for (size_t i = floorStart; i < last; ++i)
+			floors.push_back(&(regionsBegin + i)->floorRegion);
+	}
+	if (roofCount > 0) {
+		for (size_t i = roofStart; i < roofEnd; ++i)
+			roofs.push_back(&(regionsBegin + i)->roofRegion);
+	}
+	RegionWindowUnion floorWindows(floors, 
+			floorCount > 0 ? floorCount - 1 : 0, 0);
+	RegionWindowUnion roofWindows(roofs, 
+			0, roofCount > 0 ? roofCount - 1 : 0);
+
+	int layerCount = last - first;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) \
+			num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+	for (int i = 0; i < layerCount; ++i) {
+		size_t sequenceNumber = first + i;
+		RegionList::iterator current = regionsBegin + sequenceNumber;
 
 		const GridRanges &surface = current->flatSurface;
+#ifdef OMPFF
+		#pragma omp critical (regioner_progress)
+#endif
 		tick();
 
 		// Solids
 		//GridRanges combinedSolid;
-        LoopList combinedLoops;
 
 //		combinedSolid.xRays.resize(surface.xRays.size());
 //		combinedSolid.yRays.resize(surface.yRays.size());
 
-		//TODO: no reason to get bounds separately from the combination
-
-		//find the bounds we will be combinging regions across
-		RegionList::iterator firstFloor = current;
-        RegionList::iterator floorEnd = current;
-		for (unsigned int i = 1; i < grueCfg.get_floorLayerCount() &&
-				firstFloor != regionsBegin; ++i)
-			--firstFloor;
-
-		RegionList::iterator lastRoof = current;
-        RegionList::iterator roofEnd = current;
-		for (unsigned int i = 1; i < grueCfg.get_roofLayerCount() &&
-				lastRoof != regionsEnd - 1; ++i)
-			++lastRoof;
-        
-        if(grueCfg.get_floorLayerCount() > 0)
-            ++floorEnd;
-        if(grueCfg.get_roofLayerCount() > 0)
-            --roofEnd;
-		//combine floors
-		for (RegionList::iterator floor = firstFloor;
-				floor != floorEnd; ++floor) {
-//			GridRanges multiFloor;
-
-//			grid.gridRangeUnion(combinedSolid, floor->flooring, multiFloor);
-//			combinedSolid = multiFloor;
-            loopsUnion(combinedLoops, floor->floorLoops);
-		}
-
-		//combine roofs
-		for (RegionList::iterator roof = lastRoof;
-				roof != roofEnd; --roof) {
-//			GridRanges multiRoof;
-
-//			grid.gridRangeUnion(combinedSolid, roof->roofing, multiRoof);
-//			combinedSolid = multiRoof;
-            loopsUnion(combinedLoops, roof->roofLoops);
-		}
+		//combine floors below and roofs above in one pass
+        std::vector<const ClipperRegion*> solidPieces;
+        if (floorCount > 0)
+            floorWindows.pieces(sequenceNumber - floorStart, solidPieces);
+        if (roofCount > 0)
+            roofWindows.pieces(sequenceNumber - roofStart, solidPieces);
+        ClipperRegion combinedRegion;
+        regionsUnion(combinedRegion, solidPieces);
 
 		// solid now contains the combination of combinedSolid regions from
 		// multiple slices. We need to extract the perimeter from it
 
 //		grid.gridRangeIntersection(surface, combinedSolid, current->solid);
-        loopsIntersection(combinedLoops, current->interiorLoops);
-        LoopList sparseLoops;
-        loopsDifference(sparseLoops, current->interiorLoops, combinedLoops);
-        
+        regionsIntersection(combinedRegion, current->interiorRegion);
+        ClipperRegion sparseRegion;
+        regionsDifference(sparseRegion, current->interiorRegion, 
+                combinedRegion);
+        LoopList combinedLoops, sparseLoops;
+        combinedRegion.toLoops(combinedLoops);
+        sparseRegion.toLoops(sparseLoops);
+
 
 		// TODO: move me to the slicer
-		GridRanges sparseInfill, sparsePreInfill, solidInfill;
+		//the pather only reads rays along the infill direction of this 
+		//layer, so only those are cast, and only the subsampled lines 
+		//of sparse infill and support
+		axis_e axis = infillAlongX(grueCfg, sequenceNumber) ? 
+				X_AXIS : Y_AXIS;
+		GridRanges sparseInfill, solidInfill;
         
-        gridRangesForSlice(combinedLoops, grid, solidInfill);
-        gridRangesForSlice(sparseLoops, grid, sparsePreInfill);
+        grid.createGridRanges(combinedLoops, axis, 0, solidInfill);
         
 		size_t infillSkipCount = (int) (1 / grueCfg.get_infillDensity()) - 1;
 
-		grid.subSample(sparsePreInfill, infillSkipCount, sparseInfill);
+		grid.createGridRanges(sparseLoops, axis, infillSkipCount, 
+				sparseInfill);
         
         if(grueCfg.get_doSupport() || grueCfg.get_doRaft()) {
             size_t supportSkipCount = 0;
+            bool supported = false;
             if(grueCfg.get_doRaft() && sequenceNumber < grueCfg.get_raftLayers()) {
                 supportSkipCount = (int) (1 / grueCfg.get_raftDensity()) - 1;
-                grid.subSample(current->supportSurface, supportSkipCount,
-                        current->support);
+                supported = true;
             } else if(grueCfg.get_doSupport()) {
                 supportSkipCount = (int) (1 / grueCfg.get_supportDensity()) - 1;
-                grid.subSample(current->supportSurface, supportSkipCount,
-                        current->support);
+                supported = true;
+            }
+            if(supported) {
+                //inset supportloops by a fraction of supportmargin
+                LoopList insetSupportLoops;
+                loopsOffset(insetSupportLoops, current->supportLoops, 
+                        -0.01);
+                grid.createGridRanges(insetSupportLoops, axis, 
+                        supportSkipCount, current->support);
             }
         }
 
 		//grid.gridRangeUnion(current->solid, sparseInfill, current->infill);
-        current->infill.xRays.resize(surface.xRays.size());
-        current->infill.yRays.resize(surface.yRays.size());
-        
+        std::vector<ScalarRange> line;
         for(size_t x = 0; x < surface.xRays.size(); ++x) {
-            current->infill.xRays[x].insert(
-                    current->infill.xRays[x].end(), 
-                    sparseInfill.xRays[x].begin(), 
+            line.assign(sparseInfill.xRays[x].begin(), 
                     sparseInfill.xRays[x].end());
-            current->infill.xRays[x].insert(
-                    current->infill.xRays[x].end(), 
+            line.insert(line.end(), 
                     solidInfill.xRays[x].begin(), 
                     solidInfill.xRays[x].end());
+            current->infill.xRays.push_back(line);
         }
         for(size_t y = 0; y < surface.yRays.size(); ++y) {
-            current->infill.yRays[y].insert(
-                    current->infill.yRays[y].end(), 
-                    sparseInfill.yRays[y].begin(), 
+            line.assign(sparseInfill.yRays[y].begin(), 
                     sparseInfill.yRays[y].end());
-            current->infill.yRays[y].insert(
-                    current->infill.yRays[y].end(), 
+            line.insert(line.end(), 
                     solidInfill.yRays[y].begin(), 
                     solidInfill.yRays[y].end());
+            current->infill.yRays.push_back(line);
         }
 	}
+}
 
+bool mgl::infillAlongX(const GrueConfig& grueCfg, size_t layerIndex) {
+	size_t held = 0;
+	if (grueCfg.get_doRaft() && grueCfg.get_raftAligned() && 
+			layerIndex > 1 && grueCfg.get_raftLayers() > 2) {
+		held = std::min<size_t>(layerIndex, 
+				grueCfg.get_raftLayers() - 1) - 1;
+	}
+	//the first layer runs along x
+	return (layerIndex - held) % 2 == 0;
 }
 
 void Regioner::gridRangesForSlice(const std::list<LoopList>& allInsetsForSlice,
@@ -650,7 +869,6 @@ void Regioner::gridRangesForSlice(const LoopList& innerMostLoops,
 */
 
 #include "intersection_index.h"
-#include "basic_boxlist.h"
 
 #include <algorithm>
 #include <math.h>
@@ -860,6 +1078,67 @@ bool segmentIntersection(const LineSegment2 &first,const LineSegment2 &second,
     return true;
 } 
 
+/**
+   @brief Orders numbered segments by the order they were inserted in
+ */
+static bool numberLess(const NumberedSegment &first,
+                       const NumberedSegment &second) {
+    return first.second < second.second;
+}
+
+void SegmentIndex::insert(const LineSegment2 &segment) {
+    NumberedSegment numbered(segment, m_count++);
+    m_erased.push_back(false);
+    m_pending.push_back(pending_segment(numbered, 
+            to_bbox<NumberedSegment>::bound(numbered)));
+    //repacking costs about as much as a few linear passes over the 
+    //pending list, so only do it once that list is a fair part of the tree
+    if (m_pending.size() > 32 && m_pending.size() * 8 > m_tree.size()) {
+        for (pending_list::const_iterator pending = m_pending.begin();
+             pending != m_pending.end(); ++pending)
+            m_tree.insert(pending->first);
+        m_pending.clear();
+    }
+}
+
+size_t SegmentIndex::erase(const LineSegment2 &segment) {
+    numbered_list found;
+    candidates(found, LineSegmentFilter(segment));
+    size_t erased = 0;
+    for (numbered_list::const_iterator numbered = found.begin();
+         numbered != found.end(); ++numbered) {
+        if (!m_erased[numbered->second] && 
+                numbered->first.a == segment.a && 
+                numbered->first.b == segment.b) {
+            m_erased[numbered->second] = true;
+            ++erased;
+        }
+    }
+    return erased;
+}
+
+void SegmentIndex::search(SegmentList &result, 
+                          const LineSegmentFilter &filt) const {
+    numbered_list found;
+    candidates(found, filt);
+    sort(found.begin(), found.end(), numberLess);
+    for (numbered_list::const_iterator numbered = found.begin();
+         numbered != found.end(); ++numbered) {
+        if (!m_erased[numbered->second])
+            result.push_back(numbered->first);
+    }
+}
+
+void SegmentIndex::candidates(numbered_list &result, 
+                              const LineSegmentFilter &filt) const {
+    m_tree.search(result, filt);
+    for (pending_list::const_iterator pending = m_pending.begin();
+         pending != m_pending.end(); ++pending) {
+        if (filt.filter(pending->second))
+            result.push_back(pending->first);
+    }
+}
+
 /**
    @brief Convenience function for finding intersecting lines in a spacial index
 */
@@ -948,17 +1227,18 @@ void Regioner::spurLoopsForSlice(const LoopList& sliceOutlines,
 
 	// the outer shell is a special case
 	std::list<LoopList>::const_iterator inner = sliceInsets.begin();
-	LoopList outset;
+	ClipperRegion outset, spurRegion;
 
     if (grueCfg.get_doExternalSpurs()) {
-        loopsOffset(outset, *inner, 0.5 * layermeasure.getLayerW()
-                      + fudgefactor,
-                    false);
+        regionsOffset(outset, ClipperRegion(*inner), 
+                      0.5 * layermeasure.getLayerW() + fudgefactor,
+                      false);
 	
         spurLoops.push_back(LoopList());
         LoopList &outerspurs = spurLoops.back();
 
-        loopsDifference(outerspurs, sliceOutlines, outset);
+        regionsDifference(spurRegion, ClipperRegion(sliceOutlines), outset);
+        spurRegion.toLoops(outerspurs);
     }
 
     if (grueCfg.get_doInternalSpurs()) {
@@ -970,15 +1250,15 @@ void Regioner::spurLoopsForSlice(const LoopList& sliceOutlines,
             LoopList &spurs = spurLoops.back();
 
             if (inner->size() > 0) {
-                outset.clear();
                 //take an inner shell and outset it the same amount that it was inset
-                loopsOffset(outset, *inner,
-                            grueCfg.get_insetDistanceMultiplier() * 
-                            layermeasure.getLayerW()
-                            + fudgefactor, false);
+                regionsOffset(outset, ClipperRegion(*inner),
+                              grueCfg.get_insetDistanceMultiplier() * 
+                              layermeasure.getLayerW()
+                              + fudgefactor, false);
 
                 //subtract the outset loop from its outer loop, what's left is a spur
-                loopsDifference(spurs, *outer, outset);
+                regionsDifference(spurRegion, ClipperRegion(*outer), outset);
+                spurRegion.toLoops(spurs);
             }
 
             outer = inner;
@@ -1609,8 +1889,16 @@ void Regioner::fillSpurLoops(const LoopList &spurLoops,
 void Regioner::spurs(RegionList::iterator regionsBegin,
                      RegionList::iterator regionsEnd,
                      LayerMeasure &layermeasure) {
-    for (RegionList::iterator region = regionsBegin;
-         region != regionsEnd; ++region) {
+    int layerCount = regionsEnd - regionsBegin;
+#ifdef OMPFF
+    #pragma omp parallel for schedule(dynamic) \
+    		num_threads(workerCount(grueCfg.get_threadCount()))
+#endif
+    for (int i = 0; i < layerCount; ++i) {
+        RegionList::iterator region = regionsBegin + i;
+#ifdef OMPFF
+        #pragma omp critical (regioner_progress)
+#endif
         tick();
 
         //get spur loops, then fill them
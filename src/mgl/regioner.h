@@ -18,7 +18,13 @@
 #include "slicer.h"
 #include "slicer_loops.h"
 #include "loop_path.h"
-#include "basic_boxlist.h"
+#include "loop_utils.h"
+#include "basic_strtree.h"
+#include "intersection_index.h"
+
+#ifdef OMPFF
+#include <omp.h>
+#endif
 
 namespace mgl {
 
@@ -73,13 +79,17 @@ public:
     std::list<LoopList> spurLoops;
 	LoopList supportLoops;
 	LoopList interiorLoops;
-    LoopList floorLoops;
-    LoopList roofLoops;
+
+    // working areas shared between regioner stages, kept in clipper 
+    // coordinates and released once infills are done
+    ClipperRegion innerInsetRegion;
+    ClipperRegion interiorRegion;
+    ClipperRegion floorRegion;
+    ClipperRegion roofRegion;
 
     std::list<OpenPathList> spurs;
 
 	GridRanges flatSurface; // # number of slices + roofCount * 2
-	GridRanges supportSurface; //flat surface outside of the actual object
 
 	GridRanges roofing;
 	GridRanges flooring;
@@ -95,10 +105,59 @@ public:
 
 typedef std::vector<LayerRegions> RegionList;
 
+/**
+ @brief Whether infill of layer @a layerIndex of the skeleton runs along x.
+ Layers take turns, except aligned raft layers above the first two, which
+ keep the direction of the layer below.
+ */
+bool infillAlongX(const GrueConfig& grueCfg, size_t layerIndex);
+
 typedef std::vector<libthing::LineSegment2> SegmentList;
 typedef std::vector<PointList> PointTable;
 
-typedef basic_boxlist<libthing::LineSegment2> SegmentIndex;
+/// a segment with the order in which it was added to a SegmentIndex
+typedef std::pair<libthing::LineSegment2, size_t> NumberedSegment;
+
+template <>
+struct to_bbox<NumberedSegment> {
+    static AABBox bound(const NumberedSegment& numbered) {
+        return to_bbox<libthing::LineSegment2>::bound(numbered.first);
+    }
+};
+
+/**
+ Spacial index of the segments spurs are built from. Segments go in a
+ packed R-tree, so a query only visits the segments near it. Queries
+ report segments in the order they were inserted, as the spur code keeps
+ the first hit in places.
+
+ Inserted segments first wait in a list that is searched linearly. They
+ move into the tree once the list holds more than 32 segments and more
+ than an eighth as many as the tree, which then repacks on the next
+ query. Erased segments are only marked, and dropped from results.
+ */
+class SegmentIndex {
+public:
+    SegmentIndex() : m_count(0) {}
+    void insert(const libthing::LineSegment2& segment);
+    /// erase all segments equal to @a segment, @return how many
+    size_t erase(const libthing::LineSegment2& segment);
+    /// copy the segments whose bounds pass @a filt into @a result
+    void search(SegmentList& result, const LineSegmentFilter& filt) const;
+private:
+    typedef std::pair<NumberedSegment, AABBox> pending_segment;
+    typedef std::vector<pending_segment> pending_list;
+    typedef std::vector<NumberedSegment> numbered_list;
+
+    /// numbered segments passing @a filt, in no particular order
+    void candidates(numbered_list& result, const LineSegmentFilter& filt) const;
+
+    basic_strtree<NumberedSegment> m_tree;
+    pending_list m_pending;
+    std::vector<bool> m_erased;
+    size_t m_count;
+};
+
 struct SpurPieceFlags {
     SpurPieceFlags() : first(true), last(true), all(true) {};
 
@@ -127,6 +186,35 @@ public:
 						  Limits& limits, //updated to reflect outsets
 						  Grid& grid);	//initialized here
 
+	/**
+	 @brief Start regioning a model a window of layers at a time, as 
+	 appendSkeleton is given their outlines, rather than all at once. 
+	 Only the layer measure ids of @a layerloops are read here, their 
+	 outlines can still be empty. Support reaches down from every layer 
+	 above, so it can't be built this way.
+	 */
+	void beginSkeleton(const LayerLoops& layerloops, 
+					   LayerMeasure &layerMeasure, 
+					   RegionList &regionlist, 
+					   Limits& limits, //updated to reflect outsets
+					   Grid& grid);	//initialized here
+
+	/**
+	 @brief Region the next slices of a model begun with beginSkeleton, 
+	 as far as their outlines allow. A roof needs the layer above it, and 
+	 solid infill the roofs above, so the top few layers given are only 
+	 finished by later calls. The call that reaches the top slice 
+	 finishes them all.
+	 @param outlinesBegin the outlines of the slices after those given so far
+	 @return one past the last layer that is finished and no longer read 
+	 by later calls, so it can be pathed and released
+	 */
+	size_t appendSkeleton(LayerLoops::const_layer_iterator outlinesBegin,
+						  LayerLoops::const_layer_iterator outlinesEnd,
+						  LayerMeasure &layerMeasure,
+						  RegionList &regionlist,
+						  const Grid& grid);
+
 	size_t initRegionList(const LayerLoops& layerloops,
 						  RegionList &regionlist, 
 						  LayerMeasure& layermeasure,
@@ -140,6 +228,14 @@ public:
 						const LayerMeasure& layermeasure,
 						std::list<LoopList>& sliceInsets,
 						LoopList &interiors);
+	/**
+	   @brief Same as above, without converting between loops and regions 
+	   @param innermost Output, the innermost shell as a region
+	*/
+	void insetsForSlice(const ClipperRegion& sliceOutlines,
+						const LayerMeasure& layermeasure,
+						std::list<LoopList>& sliceInsets,
+						ClipperRegion &innermost);
 
 	void insets(const LayerLoops::const_layer_iterator outlinesBegin,
 				const LayerLoops::const_layer_iterator outlinesEnd,
@@ -178,6 +274,18 @@ public:
 				 RegionList::iterator regionsEnd,
 				 const Grid &grid);
 
+	/**
+	 @brief Infills of layers [@a first, @a last) of the regions from 
+	 @a regionsBegin to @a regionsEnd. Floors and roofs must be done as 
+	 far below and above those layers as the floor and roof counts reach. 
+	 Unlike the above, the working regions are kept.
+	 */
+	void infills(RegionList::iterator regionsBegin,
+				 RegionList::iterator regionsEnd,
+				 size_t first,
+				 size_t last,
+				 const Grid &grid);
+
 
 	void gridRangesForSlice(const std::list<LoopList>& allInsetsForSlice, 
 							const Grid& grid, 
@@ -264,6 +372,19 @@ public:
 
 
 private:
+	/// inflate @a limits for rafts and support and lay @a grid over them
+	void initGrid(const LayerMeasure& layerMeasure, 
+				  Limits& limits, 
+				  Grid& grid);
+
+	/// index of the first model layer, after the rafts
+	size_t firstModelLayer;
+	/// layers given outlines by appendSkeleton so far
+	size_t outlinedLayers;
+	/// layers appendSkeleton has infilled so far
+	size_t infilledLayers;
+	/// layers appendSkeleton has released the working regions of
+	size_t releasedLayers;
 };
 
 }
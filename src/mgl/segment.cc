@@ -16,6 +16,8 @@
 
 #include <stdint.h>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
 using namespace mgl;
 using namespace std;
@@ -152,6 +154,144 @@ void mgl::segmentationOfTriangles(const TriangleIndices &trianglesForSlice,
 
 }
 
+const size_t mgl::TriangleBatch::CAPACITY;
+const size_t mgl::TriangleBatch::LANES;
+
+void mgl::TriangleBatch::gather(const std::vector<Triangle3Type> &allTriangles,
+		const index_t *indices, size_t count)
+{
+	triangleCount = std::min(count, CAPACITY);
+	for(size_t i = 0; i < triangleCount; i++)
+	{
+		const Triangle3Type &triangle = allTriangles[indices[i]];
+		const Point3Type &a = triangle.v(0);
+		x0[i] = a.x; y0[i] = a.y; z0[i] = a.z;
+		const Point3Type &b = triangle.v(1);
+		x1[i] = b.x; y1[i] = b.y; z1[i] = b.z;
+		const Point3Type &c = triangle.v(2);
+		x2[i] = c.x; y2[i] = c.y; z2[i] = c.z;
+		Point3Type dir = triangle.cutDirection();
+		cutX[i] = dir.x;
+		cutY[i] = dir.y;
+	}
+	// the padding is cut along with the rest, and its results ignored
+	for(size_t i = triangleCount; i < paddedSize(); i++)
+	{
+		x0[i] = y0[i] = z0[i] = 0;
+		x1[i] = y1[i] = z1[i] = 0;
+		x2[i] = y2[i] = z2[i] = 0;
+		cutX[i] = cutY[i] = 0;
+	}
+}
+
+/**
+ Triangles with a vertex within tolerance of the plane, or off it by NaN, 
+ are only marked as maybe, they need the special cases of Triangle3::cut.
+
+ Away from those cases, sliceTriangle reduces to finding the vertex alone 
+ on its side of the plane and cutting the two edges leaving it, the first 
+ toward the lower numbered of the others. Two vertices are on the same 
+ side when the product of their distances to the plane is positive, and 
+ all picks are selects on those products, with the same arithmetic as 
+ Triangle3::cut so that results match it to the bit. Comparing the sides 
+ as bools instead, or keeping the status in a narrower type, keeps GCC 
+ from vectorizing the loop for SSE2.
+ */
+void mgl::TriangleBatch::cut(Scalar z)
+{
+	// same tolerance as Triangle3::sliceTriangle
+	const Scalar tol = 1e-6;
+	size_t count = paddedSize();
+#ifdef OMPFF
+	#pragma omp simd
+#endif
+	for(size_t i = 0; i < count; i++)
+	{
+		Scalar X0 = x0[i], Y0 = y0[i], Z0 = z0[i];
+		Scalar X1 = x1[i], Y1 = y1[i], Z1 = z1[i];
+		Scalar X2 = x2[i], Y2 = y2[i], Z2 = z2[i];
+		Scalar d0 = Z0 - z, d1 = Z1 - z, d2 = Z2 - z;
+		bool near = !(fabs(d0) >= tol) | !(fabs(d1) >= tol) | 
+				!(fabs(d2) >= tol);
+		// vertex 2 is alone on its side, else vertex 1, else vertex 0
+		bool alone2 = d0 * d1 > 0;
+		bool alone1 = d0 * d2 > 0;
+		bool missed = alone2 & alone1;
+		// the lone vertex, then the others in order
+		Scalar lx = alone1 ? X1 : X0;
+		Scalar ly = alone1 ? Y1 : Y0;
+		Scalar lz = alone1 ? Z1 : Z0;
+		Scalar px = alone1 ? X0 : X1;
+		Scalar py = alone1 ? Y0 : Y1;
+		Scalar pz = alone1 ? Z0 : Z1;
+		lx = alone2 ? X2 : lx;
+		ly = alone2 ? Y2 : ly;
+		lz = alone2 ? Z2 : lz;
+		px = alone2 ? X0 : px;
+		py = alone2 ? Y0 : py;
+		pz = alone2 ? Z0 : pz;
+		Scalar qx = alone2 ? X1 : X2;
+		Scalar qy = alone2 ? Y1 : Y2;
+		Scalar qz = alone2 ? Z1 : Z2;
+
+		Scalar u = (z - lz) / (pz - lz);
+		Scalar sx = lx + u * (px - lx);
+		Scalar sy = ly + u * (py - ly);
+		Scalar v = (z - lz) / (qz - lz);
+		Scalar ex = lx + v * (qx - lx);
+		Scalar ey = ly + v * (qy - ly);
+
+		bool reverse = cutX[i] * (ex - sx) + cutY[i] * (ey - sy) < 0;
+		ax[i] = reverse ? ex : sx;
+		ay[i] = reverse ? ey : sy;
+		bx[i] = reverse ? sx : ex;
+		by[i] = reverse ? sy : ey;
+		Scalar found = missed ? CUT_MISSED : CUT_DONE;
+		status[i] = near ? Scalar(CUT_MAYBE) : found;
+	}
+}
+
+void mgl::segmentationOfTrianglesInBatches(
+		const TriangleIndices &trianglesForSlice,
+		const std::vector<Triangle3Type> &allTriangles,
+		Scalar z,
+		std::vector<Segment2Type> &segments)
+{
+	const size_t BATCH_SIZE = TriangleBatch::CAPACITY;
+	TriangleBatch batch;
+
+	size_t triangleCount = trianglesForSlice.size();
+	segments.reserve(segments.size() + triangleCount);
+	for(size_t first = 0; first < triangleCount; first += BATCH_SIZE)
+	{
+		size_t count = std::min(BATCH_SIZE, triangleCount - first);
+		const index_t *indices = &trianglesForSlice[first];
+		batch.gather(allTriangles, indices, count);
+		batch.cut(z);
+		for(size_t i = 0; i < count; i++)
+		{
+			if(batch.status[i] == TriangleBatch::CUT_MISSED)
+				continue;
+			Segment2Type s;
+			if(batch.status[i] == TriangleBatch::CUT_DONE) {
+				s.a.x = batch.ax[i];
+				s.a.y = batch.ay[i];
+				s.b.x = batch.bx[i];
+				s.b.y = batch.by[i];
+			} else {
+				Point3Type a, b;
+				if(!allTriangles[indices[i]].cut(z, a, b))
+					continue;
+				s.a.x = a.x;
+				s.a.y = a.y;
+				s.b.x = b.x;
+				s.b.y = b.y;
+			}
+			segments.push_back(s);
+		}
+	}
+}
+
 ///// Returns 's's relation to 'to' using -1, 0, or 1
 //
 //short compare(const Scalar& s, const Scalar& to, Scalar tol) {
@@ -374,6 +514,16 @@ bool mgl::sliceTriangle(const Point3Type& vertex1,
 }
 
 
+// squared distance between the end of a LineSegment2 and the start of another
+static Scalar hopDistance(const Point2Type& endOfPreviousLineSegment2,
+						const Point2Type& startOfLineSegment2)
+{
+	Point3Type end(endOfPreviousLineSegment2.x,endOfPreviousLineSegment2.y, 0);
+	Point3Type start(startOfLineSegment2.x, startOfLineSegment2.y, 0);
+	Point3Type v = end-start;
+	return v.squaredMagnitude();
+}
+
 // given a point, finds the LineSegment2 that starts the closest from that point
 // and return the distance. Also, the iterator to the closest LineSegment2 is "returned"
 Scalar findClosestLineSegment2(const Point2Type& endOfPreviousLineSegment2,
@@ -384,13 +534,10 @@ Scalar findClosestLineSegment2(const Point2Type& endOfPreviousLineSegment2,
 	bestSegmentIt = endIt; 	// just in case, we'll check for this on the caller side
 	Scalar minDist = 1e100;
 
-	Point3Type end(endOfPreviousLineSegment2.x,endOfPreviousLineSegment2.y, 0);
 	vector<Segment2Type>::iterator it = startIt;
 	while(it != endIt)
 	{
-		Point3Type start(it->a.x, it->a.y, 0);
-		Point3Type v = end-start;
-		Scalar distance = v.squaredMagnitude();
+		Scalar distance = hopDistance(endOfPreviousLineSegment2, it->a);
 		if (distance < minDist)
 		{
 			minDist = distance;
@@ -402,7 +549,111 @@ Scalar findClosestLineSegment2(const Point2Type& endOfPreviousLineSegment2,
 	return minDist;
 }
 
+// Buckets the start points of LineSegment2s into square cells at least
+// sqrt(tol) wide, keyed and sorted so that a cell is found by binary search.
+// Any start point within hop distance tol of a query point then lies in one
+// of the 3x3 cells around it, which turns the common "next segment of this
+// loop" lookup into a constant amount of work.
+class SegmentStartGrid {
+public:
+	SegmentStartGrid(const vector<Segment2Type>& segments, Scalar tol)
+			: usable(false), cellSize(0), minX(0), minY(0) {
+		if(segments.empty() || !(tol > 0))
+			return;
+		Scalar maxX = segments[0].a.x;
+		Scalar maxY = segments[0].a.y;
+		minX = maxX;
+		minY = maxY;
+		for(size_t id = 0; id < segments.size(); ++id) {
+			const Point2Type& a = segments[id].a;
+			// inf - inf and nan - nan are both nan
+			if(!(a.x - a.x == 0) || !(a.y - a.y == 0))
+				return; // not finite, leave it to the exhaustive search
+			minX = std::min(minX, a.x);
+			maxX = std::max(maxX, a.x);
+			minY = std::min(minY, a.y);
+			maxY = std::max(maxY, a.y);
+		}
+		// a little slack so that rounding in the cell computation can't
+		// push a point within tol two cells away, and a cap on the number of
+		// cells per axis to keep keys in range
+		cellSize = std::max(1.01 * sqrt(tol), 
+				std::max(maxX - minX, maxY - minY) / MAX_CELLS);
+		cells.reserve(segments.size());
+		for(size_t id = 0; id < segments.size(); ++id) {
+			const Point2Type& a = segments[id].a;
+			cells.push_back(std::make_pair(cellKey(cellIndex(a.x, minX), 
+					cellIndex(a.y, minY)), id));
+		}
+		std::sort(cells.begin(), cells.end());
+		usable = true;
+	}
+	bool valid() const { return usable; }
+	/**
+	 @brief find the closest start point to @a point among the neighbouring 
+	 cells, ignoring segments placed at or before position @a placed.
+	 Ties are broken in favour of the lowest current position.
+	 @param starts the start point of each segment, by id
+	 @param positions the current position of each segment, by id
+	 @return false if no start point was found in the neighbouring cells
+	 */
+	bool findClosest(const Point2Type& point, 
+			const vector<Point2Type>& starts, 
+			const vector<size_t>& positions, 
+			size_t placed, 
+			size_t& bestId, 
+			Scalar& bestDistance) const {
+		Scalar fx = floor((point.x - minX) / cellSize);
+		Scalar fy = floor((point.y - minY) / cellSize);
+		if(!(fx >= -1 && fx <= MAX_CELLS + 1 && fy >= -1 && fy <= MAX_CELLS + 1))
+			return false;
+		bool found = false;
+		int64_t cx = int64_t(fx);
+		int64_t cy = int64_t(fy);
+		for(int64_t x = cx - 1; x <= cx + 1; ++x) {
+			for(int64_t y = cy - 1; y <= cy + 1; ++y) {
+				if(x < 0 || y < 0 || x > MAX_CELLS || y > MAX_CELLS)
+					continue;
+				cell_entry lowest(cellKey(x, y), 0);
+				for(cell_list::const_iterator it = std::lower_bound(
+						cells.begin(), cells.end(), lowest);
+						it != cells.end() && it->first == lowest.first;
+						++it) {
+					size_t id = it->second;
+					if(positions[id] <= placed)
+						continue;
+					Scalar distance = hopDistance(point, starts[id]);
+					if(!found || distance < bestDistance || 
+							(distance == bestDistance && 
+							positions[id] < positions[bestId])) {
+						found = true;
+						bestId = id;
+						bestDistance = distance;
+					}
+				}
+			}
+		}
+		return found;
+	}
+private:
+	typedef std::pair<int64_t, size_t> cell_entry;
+	typedef vector<cell_entry> cell_list;
+	static const int64_t MAX_CELLS = 1 << 20;
+
+	int64_t cellIndex(Scalar coordinate, Scalar minimum) const {
+		return std::min(int64_t(floor((coordinate - minimum) / cellSize)), 
+				MAX_CELLS);
+	}
+	static int64_t cellKey(int64_t x, int64_t y) {
+		return x * (MAX_CELLS + 2) + y;
+	}
 
+	bool usable;
+	Scalar cellSize;
+	Scalar minX;
+	Scalar minY;
+	cell_list cells;
+};
 
 void mgl::loopsAndHoleOgy(std::vector<Segment2Type> &segments,
 		Scalar tol,
@@ -416,20 +667,59 @@ void mgl::loopsAndHoleOgy(std::vector<Segment2Type> &segments,
 
 	distances.push_back(0); // this value is not used, it represents the distance between the
 							// first LineSegment2 and the one before (and there is no LineSegment2 before)
-	for(vector<Segment2Type>::iterator i = segments.begin(); i != segments.end(); i++)
+
+	// Segments are tracked by their original index (id) while they get
+	// swapped around, so the grid of start points never needs updating.
+	// A hop shorter than tol is always found among the neighbouring cells;
+	// longer hops (a loop closing) fall back to scanning the remaining
+	// segments, which gives exactly the same choice as a full scan.
+	SegmentStartGrid grid(segments, tol);
+	vector<Point2Type> starts;
+	vector<size_t> ids;
+	vector<size_t> positions;
+	if(grid.valid())
+	{
+		starts.reserve(segments.size());
+		ids.reserve(segments.size());
+		positions.reserve(segments.size());
+		for(size_t id = 0; id < segments.size(); id++)
+		{
+			starts.push_back(segments[id].a);
+			ids.push_back(id);
+			positions.push_back(id);
+		}
+	}
+	for(size_t i = 0; i < segments.size(); i++)
 	{
-		Point2Type &startingPoint = i->b;
-		vector<Segment2Type>::iterator startIt = i+1;
+		Point2Type &startingPoint = segments[i].b;
+		vector<Segment2Type>::iterator startIt = segments.begin() + i + 1;
 		vector<Segment2Type>::iterator bestSegmentIt;
 		if(startIt != segments.end())
 		{
-			Scalar distance = findClosestLineSegment2(startingPoint, startIt, segments.end(), bestSegmentIt);
+			Scalar distance = 0;
+			size_t bestId = 0;
+			if(grid.valid() && grid.findClosest(startingPoint, starts, 
+					positions, i, bestId, distance) && distance < tol)
+			{
+				bestSegmentIt = segments.begin() + positions[bestId];
+			}
+			else
+			{
+				distance = findClosestLineSegment2(startingPoint, startIt, segments.end(), bestSegmentIt);
+			}
 			if(bestSegmentIt != segments.end())
 			{
 				// Swap the segments, because the best is the closest segment to the current one
 				swap(*startIt, *bestSegmentIt);
 				distances.push_back(distance);
-
+				if(grid.valid())
+				{
+					size_t startPos = i + 1;
+					size_t bestPos = bestSegmentIt - segments.begin();
+					swap(ids[startPos], ids[bestPos]);
+					positions[ids[startPos]] = startPos;
+					positions[ids[bestPos]] = bestPos;
+				}
 			}
 		}
 	}
@@ -35,12 +35,63 @@ void createPolysFromloopSegments(const SegmentVector &SegmentVector, Polygons& l
 // segments are OK, but polys are better for paths (no repeat point)
 void segments2polygon(const std::vector<Segment2Type> & segments, mgl::Polygon &loop);
 
+/**
+ Up to CAPACITY triangles of a mesh stored for slicing, one array per 
+ coordinate rather than one Triangle3 each, and the segments cutting them 
+ against a z plane gives. The cut is a single pass of selects over arrays 
+ of one width, padded to a multiple of LANES, so the compiler vectorizes 
+ it at -O2. Batches are gathered from the mesh as they are cut, so slicing 
+ keeps no second copy of the mesh.
+ */
+class TriangleBatch {
+public:
+	/// small enough for the stack, large enough to keep the kernel busy
+	static const size_t CAPACITY = 256;
+	/// the cut covers a multiple of this many triangles, so it needs no 
+	/// scalar remainder at any vector width up to 512 bits
+	static const size_t LANES = 8;
+	/// what cutting a triangle found
+	enum CutStatus { CUT_MISSED = 0, CUT_DONE = 1, CUT_MAYBE = 2 };
+
+	TriangleBatch() : triangleCount(0) {}
+	/// Store triangles @a indices [0, @a count) of @a allTriangles, 
+	/// at most CAPACITY of them
+	void gather(const std::vector<Triangle3Type> &allTriangles, 
+			const index_t *indices, size_t count);
+	/// Cut the stored triangles at @a z, into segment ends and status
+	void cut(Scalar z);
+	size_t size() const { return triangleCount; }
+
+	Scalar x0[CAPACITY], y0[CAPACITY], z0[CAPACITY];
+	Scalar x1[CAPACITY], y1[CAPACITY], z1[CAPACITY];
+	Scalar x2[CAPACITY], y2[CAPACITY], z2[CAPACITY];
+	/// cut direction, in the plane, of each triangle
+	Scalar cutX[CAPACITY], cutY[CAPACITY];
+	/// segment cut from each triangle, from (ax, ay) to (bx, by)
+	Scalar ax[CAPACITY], ay[CAPACITY], bx[CAPACITY], by[CAPACITY];
+	/// CutStatus of each triangle, a Scalar so that the cut stays at 
+	/// the width of the coordinates
+	Scalar status[CAPACITY];
+private:
+	size_t paddedSize() const { 
+		return (triangleCount + LANES - 1) & ~(LANES - 1); 
+	}
+	size_t triangleCount;
+};
+
 // turns triangles into lines
 void segmentationOfTriangles(const TriangleIndices &trianglesForSlice,
 		const std::vector<Triangle3Type> &allTriangles,
 		Scalar z,
 		std::vector<Segment2Type> &segments);
 
+// turns triangles into lines, gathering them into a TriangleBatch at a 
+// time. Gives the same segments as segmentationOfTriangles.
+void segmentationOfTrianglesInBatches(const TriangleIndices &trianglesForSlice,
+		const std::vector<Triangle3Type> &allTriangles,
+		Scalar z,
+		std::vector<Segment2Type> &segments);
+
 // Assembles lines segments into loops (perimeter loops and holes)
 void loopsAndHoleOgy(std::vector<Segment2Type> &segments,
 					Scalar tol,
@@ -9,6 +9,10 @@
 #include "segmenter.h"
 #include "mgl.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
 namespace mgl{
 
 using namespace std;
@@ -16,29 +20,68 @@ using namespace std;
 
 Segmenter::Segmenter(const GrueConfig& config) 
         : zTapeMeasure(config.get_firstLayerZ(), 
-        config.get_layerH(), config.get_layerWidthRatio()) {}
+        config.get_layerH(), config.get_layerWidthRatio()), 
+        allTriangles(NULL), slices(0) {}
 const SliceTable& Segmenter::readSliceTable() const{
+	if (sliceTable.size() != slices) {
+		sliceTable.assign(slices, TriangleIndices());
+		for (SliceSweep sweep(*this); sweep.sliceId() < slices; 
+				sweep.advance()) {
+			sliceTable[sweep.sliceId()] = sweep.triangles();
+		}
+	}
 	return sliceTable;
 }
 const LayerMeasure& Segmenter::readLayerMeasure() const{
 	return zTapeMeasure;
 }
 const vector<Triangle3Type>& Segmenter::readAllTriangles() const{
-	return allTriangles;
+	static const vector<Triangle3Type> noTriangles;
+	return allTriangles ? *allTriangles : noTriangles;
 }
 const Limits& Segmenter::readLimits() const{
 	return limits;
 }
+size_t Segmenter::sliceCount() const{
+	return slices;
+}
 
 void Segmenter::tablaturize(const Meshy& mesh){
-	allTriangles = mesh.readAllTriangles();
+	tablaturize(mesh, 0, std::numeric_limits<size_t>::max());
+}
+
+class FirstSliceLess {
+public:
+	FirstSliceLess(const std::vector<std::pair<unsigned int, 
+			unsigned int> >& ranges) : ranges(ranges) {}
+	bool operator()(index_t lhs, index_t rhs) const {
+		return ranges[lhs].first < ranges[rhs].first;
+	}
+private:
+	const std::vector<std::pair<unsigned int, unsigned int> >& ranges;
+};
+
+void Segmenter::tablaturize(const Meshy& mesh, 
+		size_t sliceBegin, size_t sliceEnd){
+	allTriangles = &mesh.readAllTriangles();
 	limits = mesh.readLimits();
-	for(size_t i=0; i<allTriangles.size(); ++i)
-		updateSlicesTriangle(i);
+	sliceTable.clear();
+	slices = 0;
+	triangleSlices.resize(allTriangles->size());
+	risingTriangles.clear();
+	for(size_t i=0; i<allTriangles->size(); ++i) {
+		SliceRange range = slicesOfTriangle((*allTriangles)[i]);
+		triangleSlices[i] = range;
+		slices = std::max(slices, size_t(range.second) + 1);
+		if (range.second >= sliceBegin && range.first < sliceEnd)
+			risingTriangles.push_back(i);
+	}
+	//stable, so triangles starting on the same slice stay in index order
+	std::stable_sort(risingTriangles.begin(), risingTriangles.end(), 
+			FirstSliceLess(triangleSlices));
 }
-void Segmenter::updateSlicesTriangle(size_t newTriangleId){
-	Triangle3Type t = allTriangles[newTriangleId];
-	
+Segmenter::SliceRange Segmenter::slicesOfTriangle(
+		const Triangle3Type& t) const{
 	Point3Type a, b, c;
 	t.zSort(a, b, c);
 
@@ -50,24 +93,46 @@ void Segmenter::updateSlicesTriangle(size_t newTriangleId){
 	if (maxSliceIndex - minSliceIndex > 1)
 		maxSliceIndex--;
 
-	//		Log::often() << "Min max index = [" <<  minSliceIndex << ", "<< maxSliceIndex << "]"<< std::endl;
-	//		Log::often() << "Max index =" <<  maxSliceIndex << std::endl;
-	unsigned int currentSliceCount = sliceTable.size();
-	if (maxSliceIndex >= currentSliceCount) {
-		unsigned int newSize = maxSliceIndex + 1;
-		sliceTable.resize(newSize); // make room for potentially new slices
-		//			Log::often() << "- new slice count: " << sliceTable.size() << std::endl;
-	}
+	return SliceRange(minSliceIndex, maxSliceIndex);
+}
 
-	//		 Log::often() << "adding triangle " << newTriangleId << " to layer " << minSliceIndex  << " to " << maxSliceIndex << std::endl;
-	for (size_t i = minSliceIndex; i <= maxSliceIndex; i++) {
-		TriangleIndices &trianglesForSlice = sliceTable[i];
-		trianglesForSlice.push_back(newTriangleId);
-		//			Log::often() << "   !adding triangle " << newTriangleId << " to layer " << i  << " (size = " << trianglesForSlice.size() << ")" << std::endl;
+SliceSweep::SliceSweep(const Segmenter& seg, size_t sliceId) 
+		: seg(seg), current(sliceId), nextRising(0) {
+	const TriangleIndices& rising = seg.risingTriangles;
+	for (; nextRising < rising.size() && 
+			seg.triangleSlices[rising[nextRising]].first <= sliceId; 
+			++nextRising) {
+		index_t triangle = rising[nextRising];
+		if (seg.triangleSlices[triangle].second >= sliceId)
+			active.push_back(triangle);
 	}
+	std::sort(active.begin(), active.end());
 }
 
-
-
+void SliceSweep::advance() {
+	++current;
+	//drop the triangles that end below the new slice
+	TriangleIndices::iterator kept = active.begin();
+	for (TriangleIndices::const_iterator iter = active.begin(); 
+			iter != active.end(); 
+			++iter) {
+		if (seg.triangleSlices[*iter].second >= current)
+			*kept++ = *iter;
+	}
+	active.erase(kept, active.end());
+	//merge in the ones that start on it, already in index order
+	const TriangleIndices& rising = seg.risingTriangles;
+	size_t firstRising = nextRising;
+	for (; nextRising < rising.size() && 
+			seg.triangleSlices[rising[nextRising]].first <= current; 
+			++nextRising) {}
+	if (nextRising != firstRising) {
+		merged.clear();
+		std::merge(active.begin(), active.end(), 
+				rising.begin() + firstRising, rising.begin() + nextRising, 
+				std::back_inserter(merged));
+		active.swap(merged);
+	}
 }
 
+}
@@ -14,28 +14,80 @@
 #include "mgl.h"
 #include "meshy.h"
 
+#include <utility>
+
 namespace mgl{
 
 class GrueConfig;
 
+/**
+ Sorts the triangles of a mesh into the slices they cross. The segmenter 
+ refers to the triangles of the mesh it was given rather than copying 
+ them, so that mesh must outlive any use of readAllTriangles, and must 
+ not be changed after tablaturize.
+
+ Rather than a list of triangles for every slice, which grows with 
+ triangles times the slices each one spans, the segmenter only keeps the 
+ range of slices of every triangle, sorted by the lowest slice. Use a 
+ SliceSweep to get the triangles of each slice in turn.
+ */
 class Segmenter {
 public:
     Segmenter(const GrueConfig& config);
+	/// Triangles of every slice, built on first use. This takes as much 
+	/// memory as the sweep avoids, it is meant for inspection and tests.
 	const SliceTable& readSliceTable() const;
 	const LayerMeasure& readLayerMeasure() const;
 	const std::vector<Triangle3Type>& readAllTriangles() const;
 	const Limits& readLimits() const;
+	/// Number of slices from the bottom of the model to its top
+	size_t sliceCount() const;
 	void tablaturize(const Meshy& mesh);
+	/// Like tablaturize, but only keeps the triangles that cross a slice 
+	/// in [@a sliceBegin, @a sliceEnd). The slice count is still that of 
+	/// the whole model, slices outside the range may miss triangles.
+	void tablaturize(const Meshy& mesh, size_t sliceBegin, size_t sliceEnd);
 private:
-	void updateSlicesTriangle(size_t newTriangleId);	
+	friend class SliceSweep;
+	/// first and last slice crossed by a triangle
+	typedef std::pair<unsigned int, unsigned int> SliceRange;
+
+	SliceRange slicesOfTriangle(const Triangle3Type& t) const;
 	
-	SliceTable sliceTable;
+	mutable SliceTable sliceTable;
 	LayerMeasure zTapeMeasure;
 	
-	std::vector<Triangle3Type> allTriangles;
+	const std::vector<Triangle3Type>* allTriangles; /// owned by the mesh
+	std::vector<SliceRange> triangleSlices; /// by triangle index
+	TriangleIndices risingTriangles; /// by first slice, then index
+	size_t slices;
 	Limits limits;
 };
 
+/**
+ Walks up the slices of a segmenter, keeping the triangles that cross the 
+ current slice. Moving to the next slice only touches the triangles that 
+ end below it or start on it. Starting somewhere other than the bottom 
+ costs a pass over the triangles starting below, so walk runs of slices 
+ rather than starting a sweep for each one.
+ */
+class SliceSweep {
+public:
+	/// Start at slice @a sliceId of @a seg
+	SliceSweep(const Segmenter& seg, size_t sliceId = 0);
+	/// Move up to the next slice
+	void advance();
+	size_t sliceId() const { return current; }
+	/// Triangles crossing the current slice, in increasing index order
+	const TriangleIndices& triangles() const { return active; }
+private:
+	const Segmenter& seg;
+	size_t current;
+	size_t nextRising; /// first of risingTriangles not yet reached
+	TriangleIndices active;
+	TriangleIndices merged;
+};
+
 }
 
 #endif	/* SEGMENTER_H */
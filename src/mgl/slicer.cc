@@ -1,4 +1,6 @@
 #include <vector>
+#include <algorithm>
+#include <iterator>
 
 #include "slicer.h"
 
@@ -9,59 +11,88 @@ Slicer::Slicer(const SlicerConfig &slicerCfg, ProgressBar *progress)
 	:Progressive(progress) {
 	layerCfg.firstLayerZ = slicerCfg.firstLayerZ;
 	layerCfg.layerH = slicerCfg.layerH;
+	threadCount = slicerCfg.threadCount;
 }
 Slicer::Slicer(const GrueConfig& grueCfg, ProgressBar* progress)
     :Progressive(progress) {
     layerCfg.firstLayerZ = grueCfg.get_firstLayerZ();
     layerCfg.layerH = grueCfg.get_layerH();
+    threadCount = grueCfg.get_threadCount();
 }
 void Slicer::generateLoops(const Segmenter& seg, LayerLoops& layerloops) {
-	unsigned int sliceCount = seg.readSliceTable().size();
-	initProgress("outlines", sliceCount);
+	generateLoops(seg, layerloops, 0, seg.sliceCount());
+}
+
+void Slicer::generateLoops(const Segmenter& seg, 
+		LayerLoops& layerloops, 
+		size_t sliceBegin, 
+		size_t sliceEnd) {
+	sliceEnd = std::min(sliceEnd, seg.sliceCount());
+	sliceBegin = std::min(sliceBegin, sliceEnd);
+	initProgress("outlines", sliceEnd - sliceBegin);
 	
+	beginLoops(seg, layerloops);
+	LayerLoops::layer_iterator layers = layerloops.begin();
+	std::advance(layers, sliceBegin);
+	loopsForSlices(seg, layers, sliceBegin, sliceEnd);
+}
+
+void Slicer::beginLoops(const Segmenter& seg, LayerLoops& layerloops) {
 	layerloops.layerMeasure = seg.readLayerMeasure();
 	layerloops.layerMeasure.getLayerAttributes(0).delta = layerCfg.firstLayerZ;
 	
-	for (size_t sliceId = 0; sliceId < sliceCount; sliceId++) {
-		tick();
+	/*
+	 Layer attributes live in a shared LayerMeasure, so all layers are 
+	 created up front in slice order. Each slice only reads the segmenter, 
+	 which lets the outlines be filled in concurrently afterwards.
+	 */
+	for (size_t sliceId = 0; sliceId < seg.sliceCount(); sliceId++) {
 		LayerLoops::Layer currentLayer(layerloops.layerMeasure.createAttributes());
 		layerloops.layerMeasure.getLayerAttributes(currentLayer.getIndex()) = 
 				LayerMeasure::LayerAttributes(
 				layerloops.layerMeasure.sliceIndexToHeight(sliceId), 
 				layerloops.layerMeasure.getLayerH(), 
                 layerloops.layerMeasure.getLayerWidthRatio());
-		SegmentTable segments;
-		/*
-		 Function outlinesForSlice is designed to use segmentTable rather than
-		 the new Loop class. It makes use of clipper.cc, which was machine 
-		 translated from Delphi, and is not currently practical to quickly 
-		 convert to using new types. For this reason, we elected to 
-		 use this function as is, and to convert its resulting SegmentTables
-		 into lists of loops.
-		 */
-		outlinesForSlice(seg, sliceId, segments);
-		//convert all SegmentTables into loops
-		for(SegmentTable::iterator it = segments.begin();
-				it != segments.end();
-				++it){
-			Loop currentLoop;
-			Loop::cw_iterator iter = currentLoop.clockwiseEnd();
-			//convert current SegmentTable into a loop
-			for(std::vector<Segment2Type>::iterator it2 = it->begin(); 
-					it2 != it->end(); 
-					++it2){
-				//add points 1 - N
-				iter = currentLoop.insertPointAfter(it2->b, iter);
-			}
-			if(!it->empty())
-				//add point 0
-				iter = currentLoop.insertPointAfter(it->begin()->a, iter);
-			//add the loop to the current layer
-			currentLayer.push_back(currentLoop);
-		}
-		//finally, add the loop layer to the new data structure
 		layerloops.push_back(currentLayer);
 	}
+}
+
+void Slicer::loopsForSlices(const Segmenter& seg, 
+		LayerLoops::layer_iterator layers, 
+		size_t sliceBegin, 
+		size_t sliceEnd) {
+	std::vector<LayerLoops::Layer*> sliceLayers(sliceEnd - sliceBegin);
+	for (size_t i = 0; i < sliceLayers.size(); ++i, ++layers)
+		sliceLayers[i] = &*layers;
+	
+	/*
+	 Triangles are found by sweeping up the slices, and starting a sweep 
+	 costs a pass over the triangles below it, so split the range into a 
+	 few runs of consecutive slices, several per worker to keep them busy.
+	 */
+	size_t runCount = 1;
+#ifdef OMPFF
+	int workers = workerCount(threadCount);
+	runCount = 4 * workers;
+#endif
+	runCount = std::max(size_t(1), std::min(runCount, sliceEnd - sliceBegin));
+	size_t runLength = (sliceEnd - sliceBegin + runCount - 1) / runCount;
+#ifdef OMPFF
+	#pragma omp parallel for schedule(dynamic) num_threads(workers)
+#endif
+	for (int run = 0; run < int(runCount); run++) {
+		size_t runBegin = std::min(sliceBegin + run * runLength, sliceEnd);
+		size_t runEnd = std::min(runBegin + runLength, sliceEnd);
+		for (SliceSweep sweep(seg, runBegin); sweep.sliceId() < runEnd; 
+				sweep.advance()) {
+#ifdef OMPFF
+			#pragma omp critical (slicer_progress)
+#endif
+			tick();
+			loopsForSlice(seg, sweep.sliceId(), sweep.triangles(), 
+					*sliceLayers[sweep.sliceId() - sliceBegin]);
+		}
+	}
 //	Scalar gridSpacing = layerCfg.layerW * layerCfg.gridSpacingMultiplier;
 //	Limits limits = seg.readLimits();
 ////	Scalar xSpan = limits.xMax - limits.xMin;
@@ -77,18 +108,65 @@ void Slicer::generateLoops(const Segmenter& seg, LayerLoops& layerloops) {
 //	layerloops.grid.init(limits, gridSpacing);
 }
 
+void Slicer::loopsForSlice(const Segmenter& seg, size_t sliceId, 
+		LayerLoops::Layer& layer) {
+	SliceSweep sweep(seg, sliceId);
+	loopsForSlice(seg, sliceId, sweep.triangles(), layer);
+}
+
+void Slicer::loopsForSlice(const Segmenter& seg, size_t sliceId, 
+		const TriangleIndices& trianglesForSlice, 
+		LayerLoops::Layer& layer) {
+	SegmentTable segments;
+	/*
+	 Function outlinesForSlice is designed to use segmentTable rather than
+	 the new Loop class. It makes use of clipper.cc, which was machine 
+	 translated from Delphi, and is not currently practical to quickly 
+	 convert to using new types. For this reason, we elected to 
+	 use this function as is, and to convert its resulting SegmentTables
+	 into lists of loops.
+	 */
+	outlinesForSlice(seg, sliceId, trianglesForSlice, segments);
+	//convert all SegmentTables into loops
+	for(SegmentTable::iterator it = segments.begin();
+			it != segments.end();
+			++it){
+		Loop currentLoop;
+		Loop::cw_iterator iter = currentLoop.clockwiseEnd();
+		//convert current SegmentTable into a loop
+		for(std::vector<Segment2Type>::iterator it2 = it->begin(); 
+				it2 != it->end(); 
+				++it2){
+			//add points 1 - N
+			iter = currentLoop.insertPointAfter(it2->b, iter);
+		}
+		if(!it->empty())
+			//add point 0
+			iter = currentLoop.insertPointAfter(it->begin()->a, iter);
+		//add the loop to the current layer
+		layer.push_back(currentLoop);
+	}
+}
+
 
 
 void Slicer::outlinesForSlice(const Segmenter& seg, size_t sliceId, SegmentTable & segments)
+{
+	SliceSweep sweep(seg, sliceId);
+	outlinesForSlice(seg, sliceId, sweep.triangles(), segments);
+}
+
+void Slicer::outlinesForSlice(const Segmenter& seg, size_t sliceId, 
+		const TriangleIndices& trianglesForSlice, SegmentTable & segments)
 {
 	Scalar tol = 1e-6;
 	const LayerMeasure & layerMeasure = seg.readLayerMeasure();
 	Scalar z = layerMeasure.sliceIndexToHeight(sliceId) + 
 			0.5 * layerMeasure.getLayerH();
 	const std::vector<Triangle3Type> & allTriangles = seg.readAllTriangles();
-	const TriangleIndices & trianglesForSlice = seg.readSliceTable()[sliceId];
 	std::vector<Segment2Type> unorderedSegments;
-	segmentationOfTriangles(trianglesForSlice, allTriangles, z, unorderedSegments);
+	segmentationOfTrianglesInBatches(trianglesForSlice, allTriangles, z, 
+			unorderedSegments);
 	assert(segments.size() ==0);
 
 	// dumpSegments("unordered_", unorderedSegments);
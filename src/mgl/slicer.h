@@ -19,6 +19,10 @@
 #include "segmenter.h"
 #include "slicer_loops.h"
 
+#ifdef OMPFF
+#include <omp.h>
+#endif
+
 namespace mgl {
 
 //// Slicer configuration data
@@ -27,11 +31,13 @@ class SlicerConfig {
 public:
 	SlicerConfig()
 			: layerH(0.27),
-			firstLayerZ(0.1) {}
+			firstLayerZ(0.1),
+			threadCount(0) {}
 
 	// These are relevant to slicer
 	Scalar layerH; //< z height of layers 1+ 9(mm)
 	Scalar firstLayerZ; //< z height of 0th layer (mm)
+	unsigned int threadCount; //< slicing workers, 0 for one per core
 };
 
 struct LayerConfig {
@@ -63,6 +69,7 @@ struct Tomograph {
 
 class Slicer : public Progressive {
 	LayerConfig layerCfg;
+	unsigned int threadCount;
 
 public:
 	/// Constructor for a slicer
@@ -74,11 +81,49 @@ public:
 	/// TBD
 	void generateLoops(const Segmenter& seg, LayerLoops& layerloops);
 
+	/// Like generateLoops, but only slices [@a sliceBegin, @a sliceEnd). 
+	/// Every layer is still created, with its attributes, so layer 
+	/// positions are those of the whole model, but layers outside the 
+	/// range are left without outlines.
+	void generateLoops(const Segmenter& seg, 
+			LayerLoops& layerloops, 
+			size_t sliceBegin, 
+			size_t sliceEnd);
+
+	/// Set up @a layerloops with the layer measure of @a seg and an empty 
+	/// layer for every slice, to be filled in by loopsForSlices.
+	void beginLoops(const Segmenter& seg, LayerLoops& layerloops);
+
+	/// Fill in the outlines of slices [@a sliceBegin, @a sliceEnd), whose 
+	/// layers start at @a layers.
+	void loopsForSlices(const Segmenter& seg, 
+			LayerLoops::layer_iterator layers, 
+			size_t sliceBegin, 
+			size_t sliceEnd);
+
+	/// Slice a single layer and append its outlines to @a layer as loops.
+	/// Only reads from @a seg, so distinct slices may run concurrently.
+	void loopsForSlice(const Segmenter& seg, 
+			size_t sliceId, 
+			LayerLoops::Layer& layer);
+
+	/// Like loopsForSlice, with the triangles crossing the slice 
+	/// already known, as when walking a SliceSweep
+	void loopsForSlice(const Segmenter& seg, 
+			size_t sliceId, 
+			const TriangleIndices& trianglesForSlice, 
+			LayerLoops::Layer& layer);
+
 	/// TBD
 	void outlinesForSlice(const Segmenter& seg,
 			size_t sliceId,
 			SegmentTable & segments);
 
+	void outlinesForSlice(const Segmenter& seg,
+			size_t sliceId,
+			const TriangleIndices& trianglesForSlice, 
+			SegmentTable & segments);
+
 	/// TBD
 	void loopsFromLineSegments(const std::vector<Segment2Type>&
 			unorderedSegments,
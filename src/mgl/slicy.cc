@@ -36,7 +36,9 @@ Slicy::Slicy(const std::vector<Triangle3Type> &allTriangles,
 		allTriangles(allTriangles),
 		limits(limits), 
 		layerH(layerH) {
-
+#ifdef OMPFF
+	omp_init_lock(&my_lock);
+#endif
 
 	openScadFile(scadFile, layerW, layerH, sliceCount);
 
@@ -58,6 +60,9 @@ Slicy::Slicy(const std::vector<Triangle3Type> &allTriangles,
 
 Slicy::~Slicy() {
 	closeScadFile();
+#ifdef OMPFF
+	omp_destroy_lock(&my_lock);
+#endif
 }
 
 void Slicy::openScadFile(const char *scadFile, double layerW, Scalar layerH, size_t sliceCount) {
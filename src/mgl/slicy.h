@@ -53,7 +53,10 @@ class Slicy {
 	Point2Type toRotationCenter;
 	Point2Type backToOrigin;
 	Limits tubularLimits;
-
+#ifdef OMPFF
+	// serializes scad output between slicing threads
+	omp_lock_t my_lock;
+#endif
 
 
 	void openScadFile(const char *scadFile, Scalar layerW, Scalar layerH, size_t sliceCount);
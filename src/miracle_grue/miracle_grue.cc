@@ -13,6 +13,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -102,9 +103,9 @@ const option::Descriptor usageDescriptor[] ={
 	{ N_SHELLS, 7, "n", "numberOfShells", Arg::Numeric,
 		"  -n \tnumber of shells per layer"},
 	{ BOTTOM_SLICE_IDX, 8, "b", "bottomIdx", Arg::Numeric,
-		"  -b \tbottom slice index"},
+		"  -b \tbottom layer index, counting raft layers"},
 	{ TOP_SLICE_IDX, 9, "t", "topIdx", Arg::Numeric,
-		"  -t \ttop slice index"},
+		"  -t \ttop layer index, counting raft layers"},
 	{ DEBUG_ME, 10, "d", "debug", Arg::Numeric,
 		"  -d \tdebug level, 0 to 99. 60 is 'info'"},
 	{ DEBUG_LAYER, 11, "l", "printLayerMessages", Arg::None,
@@ -150,6 +151,8 @@ int newParseArgs(Configuration &config,
 
 	string configFilename = "";
 	jsonProgress = false;
+	firstSliceIdx = -1;
+	lastSliceIdx = -1;
 
 	argc -= (argc > 0);
 	argv += (argc > 0); // skip program name argv[0] if present
@@ -193,8 +196,11 @@ int newParseArgs(Configuration &config,
 			config[opt.desc->longopt] = atoi(opt.arg);
 			break;
 		case BOTTOM_SLICE_IDX:
+			firstSliceIdx = atoi(opt.arg);
+			break;
 		case TOP_SLICE_IDX:
-            break;
+			lastSliceIdx = atoi(opt.arg);
+			break;
 		case FIRST_Z:
 			config[opt.desc->longopt] = atof(opt.arg);
 			break;
@@ -248,9 +254,6 @@ int newParseArgs(Configuration &config,
 		}
 	}
 
-	firstSliceIdx = -1;
-	lastSliceIdx = -1;
-
 	// [programName] and [versionStr] are always hard-code overwritten
 	config["programName"] = GRUE_PROGRAM_NAME;
 	config["versionStr"] = GRUE_VERSION;
@@ -331,7 +334,12 @@ int main(int argc, char *argv[], char *[]) // envp
 		RegionList regions;
 		std::vector<mgl::SliceData> slices;
 
+        //gcode is written a line at a time, give the file a large buffer
+        //declared before the stream, which flushes into it when destroyed
+        std::vector<char> gcodeBuffer(1 << 20);
 		std::ofstream gcodeFileStream;
+        gcodeFileStream.rdbuf()->pubsetbuf(&gcodeBuffer[0], 
+                gcodeBuffer.size());
         gcodeFileStream.open(gcodeFile.c_str(), ios::out);
         if(!gcodeFileStream) {
             Exception mixup(std::string("Bad output file: ") + 
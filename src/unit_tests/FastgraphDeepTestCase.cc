@@ -3,6 +3,7 @@
 #include <vector>
 #include <list>
 #include <sstream>
+#include <algorithm>
 
 #include "FastgraphDeepTestCase.h"
 #include "mgl/meshy.h"
@@ -109,6 +110,51 @@ void FastgraphDeepTestCase::testLoopOrdering() {
     CPPUNIT_ASSERT_EQUAL(expected, output.str());
 }
 
+void FastgraphDeepTestCase::testEntryIndex() {
+    typedef pather_optimizer_fastgraph::graph_type graph_type;
+    typedef pather_optimizer_fastgraph::NodeData NodeData;
+    
+    GrueConfig grueCfg;
+    graph_type graph;
+    //two shells and some infill, with repeated positions to force ties
+    for(int i = 0; i < 300; ++i) {
+        Point2Type position((i * 37) % 23 * 0.5, (i * 11) % 17 * 0.75);
+        PathLabel label = i % 3 == 0 ? 
+                PathLabel(PathLabel::TYP_INFILL, PathLabel::OWN_MODEL, 5) : 
+                PathLabel(PathLabel::TYP_INSET, PathLabel::OWN_MODEL, 
+                10 + i % 3);
+        graph.createNode(NodeData(position, label, i % 7 != 0));
+    }
+    pather_optimizer_fastgraph::entry_index entries(graph);
+    CPPUNIT_ASSERT(entries.valid());
+    
+    std::cout << "Testing entry index against a full scan" << std::endl;
+    Point2Type query(-3.0, 4.0);
+    while(pather_optimizer_fastgraph::entryBegin(graph) != 
+            pather_optimizer_fastgraph::entryEnd(graph)) {
+        graph_type::node_index expected = std::min_element(
+                pather_optimizer_fastgraph::entryBegin(graph), 
+                pather_optimizer_fastgraph::entryEnd(graph), 
+                pather_optimizer_fastgraph::nodeComparator(
+                grueCfg, graph, query))->getIndex();
+        graph_type::node_index found;
+        CPPUNIT_ASSERT(entries.best(query, found));
+        CPPUNIT_ASSERT_EQUAL(expected, found);
+        query = graph[found].data().getPosition() + Point2Type(0.3, -0.2);
+        entries.erase(graph[found]);
+        graph.destroyNode(graph[found]);
+    }
+    graph_type::node_index found;
+    CPPUNIT_ASSERT(!entries.best(query, found));
+    
+    std::cout << "Testing that mixed label types are rejected" << std::endl;
+    graph.createNode(NodeData(Point2Type(), PathLabel(PathLabel::TYP_INSET, 
+            PathLabel::OWN_MODEL, 10), true));
+    graph.createNode(NodeData(Point2Type(), PathLabel(PathLabel::TYP_INFILL, 
+            PathLabel::OWN_MODEL, 10), true));
+    CPPUNIT_ASSERT(!pather_optimizer_fastgraph::entry_index(graph).valid());
+}
+
 void FastgraphDeepTestCase::displayBucket(mgl::pather_optimizer_fastgraph::bucket& 
         bucket) {
     bucket.m_hierarchy.repr(std::cerr);
@@ -8,11 +8,13 @@
 class FastgraphDeepTestCase : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST_SUITE ( FastgraphDeepTestCase );
     CPPUNIT_TEST( testLoopOrdering );
+    CPPUNIT_TEST( testEntryIndex );
     CPPUNIT_TEST_SUITE_END();
 public:
     void setUp() {}
 protected:
     void testLoopOrdering();
+    void testEntryIndex();
 private:
     void displayBucket(mgl::pather_optimizer_fastgraph::bucket& bucket);
 };
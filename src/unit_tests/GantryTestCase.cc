@@ -5,6 +5,8 @@
 #include "mgl/gcoder.h"
 
 #include <iostream>
+#include <iomanip>
+#include <limits>
 #include <sstream>
 
 using namespace std;
@@ -175,4 +177,44 @@ void GantryTestCase::testConfig(){
 	CPPUNIT_ASSERT(gantryCfg.get_start_z() == z);
 }
 
+/// appendFixed must print @a value as a fixed stream of @a precision does
+static void checkFixed(Scalar value, int precision) {
+	ostringstream expected;
+	expected << fixed << setprecision(precision) << value;
+	string actual("G1 X");
+	appendFixed(actual, value, precision);
+	CPPUNIT_ASSERT_EQUAL("G1 X" + expected.str(), actual);
+}
 
+void GantryTestCase::testAppendFixed(){
+	static const Scalar values[] = {
+		0, 1, 12.345, 100, 199.99951, 1e-9, 
+		// ties, exact in binary or nearly so
+		0.5, 1.5, 2.5, 0.125, 0.375, 2.675, 1.0005, 0.0005, 1.45, 
+		1234.5625, 99.9995,
+		// large values, past the exact integer path
+		999999.9999, 1e8, 123456789.123, 1e15, 9.87654321e20, 
+		std::numeric_limits<Scalar>::max(),
+		// negative values, some of which round to zero
+		-0.0001, -0.0004999, -0.0005, -0.4, -0.5, -1e-12, -0.0, -2.5, 
+		-123.4567, -1e15,
+		// not numbers
+		std::numeric_limits<Scalar>::quiet_NaN(), 
+		-std::numeric_limits<Scalar>::quiet_NaN(),
+		std::numeric_limits<Scalar>::infinity(),
+		-std::numeric_limits<Scalar>::infinity()
+	};
+	static const int precisions[] = {0, 1, 2, 3, 4, 6, 9, 10, 12};
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+		for (size_t j = 0; j < sizeof(precisions) / sizeof(precisions[0]); 
+				++j) {
+			checkFixed(values[i], precisions[j]);
+		}
+	}
+	// a sweep over the values a print actually writes
+	for (int step = -20000; step <= 20000; ++step) {
+		Scalar value = step * 0.0125 + step * 1e-7;
+		checkFixed(value, 3);
+		checkFixed(value, 2);
+	}
+}
@@ -20,6 +20,7 @@ class GantryTestCase : public CPPUNIT_NS::TestFixture{
 	CPPUNIT_TEST( testG1Extrude );
 	CPPUNIT_TEST( testSquirtSnort );
 	CPPUNIT_TEST( testConfig );
+	CPPUNIT_TEST( testAppendFixed );
 	
 	CPPUNIT_TEST_SUITE_END();
 	
@@ -32,6 +33,7 @@ protected:
 	void testG1Extrude();
 	void testSquirtSnort();
 	void testConfig();
+	void testAppendFixed();
 };
 
 
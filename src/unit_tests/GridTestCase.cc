@@ -18,17 +18,13 @@ void GridTestCase::testGridRangesToOpenPaths() {
 	Grid grid;
 
 	ScalarRangeTable rays;
-	rays.resize(2);
 
-	ScalarRangeTable::iterator ray = rays.begin();
+	vector<ScalarRange> ray;
+	ray.push_back(ScalarRange(0, 1));
+	ray.push_back(ScalarRange(2, 3));
 
-	ray->push_back(ScalarRange(0, 1));
-	ray->push_back(ScalarRange(2, 3));
-
-	++ray;
-
-	ray->push_back(ScalarRange(0, 1));
-	ray->push_back(ScalarRange(2, 3));
+	rays.push_back(ray);
+	rays.push_back(ray);
 
 	vector<Scalar> values;
 	values.push_back(0);
@@ -76,3 +72,162 @@ void GridTestCase::testGridRangesToOpenPaths() {
 	
 
 	
+
+void GridTestCase::testCastRaysOnSlice() {
+	// diamond with its corners sitting exactly on rays
+	Loop diamond;
+	Loop::cw_iterator at = 
+			diamond.insertPointAfter(Point2Type(0, 2), diamond.clockwiseEnd());
+	at = diamond.insertPointAfter(Point2Type(2, 0), at);
+	at = diamond.insertPointAfter(Point2Type(0, -2), at);
+	at = diamond.insertPointAfter(Point2Type(-2, 0), at);
+	std::list<Loop> loops;
+	loops.push_back(diamond);
+
+	vector<Scalar> values;
+	for (int i = -3; i <= 3; i++)
+		values.push_back(i);
+
+	ScalarRangeTable xTable;
+	ScalarRangeTable yTable;
+	castRaysOnSliceAlongX(loops, values, -10, 10, xTable);
+	castRaysOnSliceAlongY(loops, values, -10, 10, yTable);
+	CPPUNIT_ASSERT_EQUAL(values.size(), xTable.size());
+	CPPUNIT_ASSERT_EQUAL(values.size(), yTable.size());
+
+	for (size_t i = 0; i < values.size(); i++) {
+		// the whole slice pass must agree with casting rays one by one
+		vector<ScalarRange> xRay;
+		vector<ScalarRange> yRay;
+		rayCastAlongX(loops, values[i], -10, 10, xRay);
+		rayCastAlongY(loops, values[i], -10, 10, yRay);
+		CPPUNIT_ASSERT_EQUAL(xRay.size(), xTable[i].size());
+		CPPUNIT_ASSERT_EQUAL(yRay.size(), yTable[i].size());
+		for (size_t j = 0; j < xRay.size(); j++) {
+			CPPUNIT_ASSERT_EQUAL(xRay[j].min, xTable[i][j].min);
+			CPPUNIT_ASSERT_EQUAL(xRay[j].max, xTable[i][j].max);
+		}
+		for (size_t j = 0; j < yRay.size(); j++) {
+			CPPUNIT_ASSERT_EQUAL(yRay[j].min, yTable[i][j].min);
+			CPPUNIT_ASSERT_EQUAL(yRay[j].max, yTable[i][j].max);
+		}
+	}
+
+	// rays through the side corners cross the loop once on each side
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, xTable[3].size());
+	CPPUNIT_ASSERT_EQUAL(-2.0, xTable[3][0].min);
+	CPPUNIT_ASSERT_EQUAL(2.0, xTable[3][0].max);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, xTable[4].size());
+	CPPUNIT_ASSERT_EQUAL(-1.0, xTable[4][0].min);
+	CPPUNIT_ASSERT_EQUAL(1.0, xTable[4][0].max);
+	// the top corner only touches its ray, the outer rays miss entirely
+	CPPUNIT_ASSERT(xTable[5].empty());
+	CPPUNIT_ASSERT(xTable[0].empty());
+	CPPUNIT_ASSERT(xTable[6].empty());
+}
+
+static void assertSameTable(const ScalarRangeTable& expected, 
+		const ScalarRangeTable& actual) {
+	CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+	for (size_t i = 0; i < expected.size(); i++) {
+		CPPUNIT_ASSERT_EQUAL(expected[i].size(), actual[i].size());
+		for (size_t j = 0; j < expected[i].size(); j++) {
+			CPPUNIT_ASSERT_EQUAL(expected[i][j].min, actual[i][j].min);
+			CPPUNIT_ASSERT_EQUAL(expected[i][j].max, actual[i][j].max);
+		}
+	}
+}
+
+void GridTestCase::testSubSampledGridRanges() {
+	Loop square;
+	Loop::cw_iterator at = 
+			square.insertPointAfter(Point2Type(-4, 4), square.clockwiseEnd());
+	at = square.insertPointAfter(Point2Type(4, 4), at);
+	at = square.insertPointAfter(Point2Type(4, -4), at);
+	at = square.insertPointAfter(Point2Type(-4, -4), at);
+	std::list<Loop> loops;
+	loops.push_back(square);
+
+	Limits limits;
+	limits.grow(Point3Type(-5, -5, 0));
+	limits.grow(Point3Type(5, 5, 1));
+	Grid grid(limits, 0.5);
+
+	GridRanges surface;
+	grid.createGridRanges(loops, surface);
+	const size_t skipCount = 2;
+	GridRanges sampled;
+	grid.subSample(surface, skipCount, sampled);
+
+	// casting only the surviving rays of one axis gives the same rays
+	GridRanges alongX;
+	grid.createGridRanges(loops, X_AXIS, skipCount, alongX);
+	assertSameTable(sampled.xRays, alongX.xRays);
+	CPPUNIT_ASSERT_EQUAL(sampled.yRays.size(), alongX.yRays.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, alongX.yRaysCount());
+
+	GridRanges alongY;
+	grid.createGridRanges(loops, Y_AXIS, skipCount, alongY);
+	assertSameTable(sampled.yRays, alongY.yRays);
+	CPPUNIT_ASSERT_EQUAL(sampled.xRays.size(), alongY.xRays.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, alongY.xRaysCount());
+
+	CPPUNIT_ASSERT(alongX.xRaysCount() > 0);
+	CPPUNIT_ASSERT(alongX.xRaysCount() < surface.xRaysCount());
+}
+
+void GridTestCase::testScalarRangeTable() {
+	vector<ScalarRange> first;
+	first.push_back(ScalarRange(0, 2));
+	first.push_back(ScalarRange(4, 6));
+	vector<ScalarRange> second;
+	second.push_back(ScalarRange(1, 5));
+
+	ScalarRangeTable a;
+	a.push_back(first);
+	a.resize(3);
+	a.push_back(second);
+	CPPUNIT_ASSERT_EQUAL((size_t) 4, a.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, a.rangeCount());
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, a[0].size());
+	CPPUNIT_ASSERT(a[1].empty());
+	CPPUNIT_ASSERT(a[2].empty());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, a[3].size());
+	CPPUNIT_ASSERT_EQUAL(4.0, a[0].back().min);
+	CPPUNIT_ASSERT_EQUAL(5.0, a[3].front().max);
+
+	ScalarRangeTable b;
+	b.push_back(second);
+	b.push_back(first);
+	b.resize(4);
+
+	// row by row the table operations match the line operations
+	ScalarRangeTable unions, differences, intersections;
+	rangeTableUnion(a, b, unions);
+	rangeTableDifference(a, b, differences);
+	rangeTableIntersection(a, b, intersections);
+	CPPUNIT_ASSERT_EQUAL(a.size(), unions.size());
+	CPPUNIT_ASSERT_EQUAL(a.size(), differences.size());
+	CPPUNIT_ASSERT_EQUAL(a.size(), intersections.size());
+	for (size_t i = 0; i < a.size(); i++) {
+		vector<ScalarRange> line;
+		rangeUnion(a[i], b[i], line);
+		CPPUNIT_ASSERT_EQUAL(line.size(), unions[i].size());
+		for (size_t j = 0; j < line.size(); j++) {
+			CPPUNIT_ASSERT_EQUAL(line[j].min, unions[i][j].min);
+			CPPUNIT_ASSERT_EQUAL(line[j].max, unions[i][j].max);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, differences[0].size());
+	CPPUNIT_ASSERT_EQUAL(1.0, differences[0][0].max);
+	CPPUNIT_ASSERT_EQUAL(5.0, differences[0][1].min);
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, intersections[0].size());
+	CPPUNIT_ASSERT_EQUAL(1.0, intersections[0][0].min);
+	CPPUNIT_ASSERT_EQUAL(5.0, intersections[0][1].max);
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, unions[1].size());
+	CPPUNIT_ASSERT(intersections[3].empty());
+
+	a.resize(1);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, a.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, a.rangeCount());
+}
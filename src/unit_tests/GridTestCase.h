@@ -9,6 +9,9 @@ class GridTestCase : public CPPUNIT_NS::TestFixture
 {
 	CPPUNIT_TEST_SUITE( GridTestCase );
 	CPPUNIT_TEST( testGridRangesToOpenPaths );
+	CPPUNIT_TEST( testCastRaysOnSlice );
+	CPPUNIT_TEST( testSubSampledGridRanges );
+	CPPUNIT_TEST( testScalarRangeTable );
     CPPUNIT_TEST_SUITE_END();
 
 
@@ -17,6 +20,9 @@ public:
 
 protected:
 	void testGridRangesToOpenPaths();
+	void testCastRaysOnSlice();
+	void testSubSampledGridRanges();
+	void testScalarRangeTable();
 
 };
 
@@ -6,7 +6,6 @@
 #include "mgl/regioner.h"
 #include "mgl/LineSegment2.h"
 #include "mgl/intersection_index.h"
-#include "mgl/basic_boxlist.h"
 #include "mgl/dump_restore.h"
 
 using namespace std;
@@ -299,7 +298,6 @@ struct SegPairLess {
 
 typedef set<SegmentPair, SegPairLess> SegmentPairSet;
 typedef vector<LineSegment2> SegmentList;
-typedef basic_boxlist<LineSegment2> SegmentIndex;
 
 void findWallPairs(const Scalar span, const SegmentList segs,
 				   SegmentIndex &index, SegmentPairSet &walls);
@@ -45,5 +45,45 @@ void LayerMeasureTestCase::testOffset() {
 	CPPUNIT_ASSERT_EQUAL(0.54 + 0.27 + 0.27, layerMeasure.getLayerPosition(second));
 }
 
-
-
+void LayerMeasureTestCase::testCachedPositions() {
+	LayerMeasure layerMeasure(0.0, 0.27, 0.43);
+	
+	//a chain of layers, each relative to the one below
+	std::vector<layer_measure_index_t> layers;
+	layers.push_back(layerMeasure.createAttributes(
+			LayerMeasure::LayerAttributes(0.5, 0.5)));
+	for (int i = 1; i < 100; ++i) {
+		layers.push_back(layerMeasure.createAttributes(
+				LayerMeasure::LayerAttributes(0.25, 0.25, 0.43, 
+				layers.back())));
+	}
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5 + 99 * 0.25, 
+			layerMeasure.getLayerPosition(layers.back()), 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5 + 49 * 0.25, 
+			layerMeasure.getLayerPosition(layers[49]), 1e-9);
+	
+	//changing a layer moves everything above it
+	layerMeasure.getLayerAttributes(layers[10]).delta += 1.0;
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5 + 9 * 0.25, 
+			layerMeasure.getLayerPosition(layers[9]), 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5 + 99 * 0.25, 
+			layerMeasure.getLayerPosition(layers.back()), 1e-9);
+	
+	//and so does moving the bed
+	layerMeasure.getLayerAttributes(0).delta = 2.0;
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.5 + 99 * 0.25, 
+			layerMeasure.getLayerPosition(layers.back()), 1e-9);
+	
+	//new layers are found too
+	layer_measure_index_t top = layerMeasure.createAttributes(
+			LayerMeasure::LayerAttributes(1.0, 0.25, 0.43, layers.back()));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(4.5 + 99 * 0.25, 
+			layerMeasure.getLayerPosition(top), 1e-9);
+	
+	//layers that were never created, and loops of bases, are errors
+	CPPUNIT_ASSERT_THROW(layerMeasure.getLayerPosition(top + 1), 
+			LayerException);
+	layerMeasure.getLayerAttributes(layers[0]).base = layers[5];
+	CPPUNIT_ASSERT_THROW(layerMeasure.getLayerPosition(layers[3]), 
+			LayerException);
+}
@@ -10,6 +10,7 @@ class LayerMeasureTestCase : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testLayer0 );
 	CPPUNIT_TEST( testCreatingLayers );
 	CPPUNIT_TEST( testOffset );
+	CPPUNIT_TEST( testCachedPositions );
 	CPPUNIT_TEST_SUITE_END();
 	
 public:
@@ -18,6 +19,7 @@ protected:
 	void testLayer0();
 	void testCreatingLayers();
 	void testOffset();
+	void testCachedPositions();
 };
 
 
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <sstream>
 #include <list>
+#include <algorithm>
 
 using namespace std;
 using namespace mgl;
@@ -535,4 +536,153 @@ void LoopPathTestCase::testConvex() {
 	}
 }
 
+static Loop squareLoop(Scalar left, Scalar bottom, Scalar size) {
+	Loop square;
+	square.insertPointBefore(Point2Type(left, bottom), square.clockwiseEnd());
+	square.insertPointBefore(Point2Type(left, bottom + size), 
+			square.clockwiseEnd());
+	square.insertPointBefore(Point2Type(left + size, bottom + size), 
+			square.clockwiseEnd());
+	square.insertPointBefore(Point2Type(left + size, bottom), 
+			square.clockwiseEnd());
+	return square;
+}
+
+void LoopPathTestCase::testClipperRegion() {
+	cout << "Testing chained region operations against loop operations" 
+			<< endl;
+	LoopList first, second, hole;
+	first.push_back(squareLoop(0, 0, 2));
+	second.push_back(squareLoop(1, 1, 2));
+	hole.push_back(squareLoop(1.25, 1.25, 0.5));
+
+	LoopList expected;
+	loopsUnion(expected, first, second);
+	loopsOffset(expected, expected, -0.25);
+	loopsDifference(expected, hole);
+
+	ClipperRegion region;
+	regionsUnion(region, ClipperRegion(first), ClipperRegion(second));
+	regionsOffset(region, region, -0.25);
+	regionsDifference(region, ClipperRegion(hole));
+	LoopList actual;
+	region.toLoops(actual);
+
+	CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+	for(LoopList::const_iterator expectedLoop = expected.begin(), 
+			actualLoop = actual.begin(); 
+			expectedLoop != expected.end(); 
+			++expectedLoop, ++actualLoop) {
+		CPPUNIT_ASSERT_EQUAL(expectedLoop->size(), actualLoop->size());
+		for(Loop::const_finite_cw_iterator expectedPoint = 
+				expectedLoop->clockwiseFinite(), 
+				actualPoint = actualLoop->clockwiseFinite(); 
+				expectedPoint != expectedLoop->clockwiseEnd(); 
+				++expectedPoint, ++actualPoint) {
+			//loop operations round to the clipper grid between steps
+			CPPUNIT_ASSERT((expectedPoint->getPoint() - 
+					actualPoint->getPoint()).magnitude() < 1e-3);
+		}
+	}
+
+	cout << "Testing empty regions" << endl;
+	ClipperRegion empty((LoopList()));
+	CPPUNIT_ASSERT(empty.empty());
+	regionsIntersection(region, empty);
+	CPPUNIT_ASSERT(region.empty());
+	region.toLoops(actual);
+	CPPUNIT_ASSERT(actual.empty());
+}
+
+static double regionArea(const ClipperRegion& region) {
+	double area = 0;
+	for(ClipperLib::Polygons::const_iterator iter = 
+			region.polygons().begin(); 
+			iter != region.polygons().end(); 
+			++iter) {
+		area += ClipperLib::Area(*iter);
+	}
+	return area;
+}
+
+void LoopPathTestCase::testRegionWindowUnion() {
+	cout << "Testing windowed unions against sequential unions" << endl;
+	std::vector<ClipperRegion> regions;
+	for(size_t i = 0; i < 9; ++i) {
+		LoopList loops;
+		loops.push_back(squareLoop(i * 0.75, (i % 3) * 0.5, 1));
+		regions.push_back(ClipperRegion(loops));
+	}
+	std::vector<const ClipperRegion*> sequence;
+	for(size_t i = 0; i < regions.size(); ++i)
+		sequence.push_back(&regions[i]);
+
+	const size_t before = 2;
+	const size_t after = 1;
+	RegionWindowUnion windows(sequence, before, after);
+	for(size_t index = 0; index < sequence.size(); ++index) {
+		size_t first = index < before ? 0 : index - before;
+		size_t last = std::min(index + after, sequence.size() - 1);
+		ClipperRegion expected;
+		for(size_t i = first; i <= last; ++i)
+			regionsUnion(expected, expected, regions[i]);
+
+		std::vector<const ClipperRegion*> pieces;
+		windows.pieces(index, pieces);
+		CPPUNIT_ASSERT(!pieces.empty() && pieces.size() <= 2);
+		ClipperRegion actual;
+		regionsUnion(actual, pieces);
+
+		CPPUNIT_ASSERT_EQUAL(expected.polygons().size(), 
+				actual.polygons().size());
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(regionArea(expected), 
+				regionArea(actual), 1e-6 * regionArea(expected));
+	}
 
+	cout << "Testing windows over an empty sequence" << endl;
+	RegionWindowUnion none(std::vector<const ClipperRegion*>(), 1, 1);
+	ClipperRegion nothing;
+	regionsUnion(nothing, std::vector<const ClipperRegion*>());
+	CPPUNIT_ASSERT(nothing.empty());
+}
+
+void LoopPathTestCase::testRegionsSimplify() {
+	cout << "Testing simplification of jagged regions" << endl;
+	//a square whose bottom edge wobbles by less than the tolerance
+	Loop jagged;
+	for(size_t i = 0; i < 10; ++i) {
+		jagged.insertPointBefore(Point2Type(i * 0.2, (i % 2) * 0.01), 
+				jagged.clockwiseEnd());
+	}
+	jagged.insertPointBefore(Point2Type(2, 0), jagged.clockwiseEnd());
+	jagged.insertPointBefore(Point2Type(2, 2), jagged.clockwiseEnd());
+	jagged.insertPointBefore(Point2Type(0, 2), jagged.clockwiseEnd());
+	//and a sliver thinner than the tolerance
+	Loop sliver;
+	sliver.insertPointBefore(Point2Type(3, 0), sliver.clockwiseEnd());
+	sliver.insertPointBefore(Point2Type(4, 0.02), sliver.clockwiseEnd());
+	sliver.insertPointBefore(Point2Type(5, 0), sliver.clockwiseEnd());
+	LoopList loops;
+	loops.push_back(jagged);
+	loops.push_back(sliver);
+	ClipperRegion region(loops);
+
+	ClipperRegion simplified;
+	regionsSimplify(simplified, region, 0.05);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), simplified.polygons().size());
+	CPPUNIT_ASSERT_EQUAL(size_t(4), simplified.polygons().front().size());
+	double area = std::fabs(regionArea(region));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(area, std::fabs(regionArea(simplified)), 
+			0.01 * area);
+
+	cout << "Testing simplification within a tighter tolerance" << endl;
+	regionsSimplify(simplified, region, 0.001);
+	CPPUNIT_ASSERT_EQUAL(region.polygons().size(), 
+			simplified.polygons().size());
+	CPPUNIT_ASSERT_EQUAL(region.polygons().front().size(), 
+			simplified.polygons().front().size());
+
+	ClipperRegion nothing;
+	regionsSimplify(nothing, ClipperRegion(), 0.05);
+	CPPUNIT_ASSERT(nothing.empty());
+}
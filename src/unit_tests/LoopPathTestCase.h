@@ -17,6 +17,9 @@ class LoopPathTestCase : public CPPUNIT_NS::TestFixture{
 	CPPUNIT_TEST( testConstLoopPath );
 	CPPUNIT_TEST( testFiniteSegment );
 	CPPUNIT_TEST( testConvex );
+	CPPUNIT_TEST( testClipperRegion );
+	CPPUNIT_TEST( testRegionWindowUnion );
+	CPPUNIT_TEST( testRegionsSimplify );
 	
 	CPPUNIT_TEST_SUITE_END();
 	
@@ -33,6 +36,9 @@ protected:
 	void testConstLoopPath();
 	void testFiniteSegment();
 	void testConvex();
+	void testClipperRegion();
+	void testRegionWindowUnion();
+	void testRegionsSimplify();
 };
 
 
@@ -5,6 +5,7 @@
 #include <iomanip>
 #include <limits>
 #include <set>
+#include <functional>
 
 
 
@@ -14,6 +15,10 @@
 #include "ModelReaderTestCase.h"
 
 #include <sys/stat.h>
+#ifndef WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 #include <bits/basic_string.h>
 
 #include "UnitTestUtils.h"
@@ -311,38 +316,20 @@ void ModelReaderTestCase::testMeshyCycleNull()
         }
     };
     MeshCfg grueCfg;
-	unsigned int t0,t1;
 	string target = inputsDir + "Null.stl";
 	string drop = outputsDir + "Null.stl";
-	string drop2 = outputsDir + "Null_v2.stl";
 
+	//a solid without facets is not a model
 	cout << "Reading test file:"  << target << endl;
 	Meshy mesh3(grueCfg);
-//	Segmenter seg3(0.35, 0.35);
-    Segmenter seg3(grueCfg);
-    Segmenter seg4(grueCfg);
-	t0=clock();
-	mesh3.readStlFile(target.c_str());
-	t1=clock()-t0;
-//	mesh3.dump(cout);
-	cout << "Read: " << target <<" in seconds: " << t1 << endl;
+	CPPUNIT_ASSERT_THROW(mesh3.readStlFile(target.c_str()), MeshyException);
+	CPPUNIT_ASSERT_EQUAL((size_t)0, mesh3.triangleCount());
+
+	//nor is the empty mesh written back out
 	cout << "Writing test file:"  << drop << endl;
 	mesh3.writeStlFile( drop.c_str());
-	unsigned int t2=clock()-t1;
-	cout << "Wrote: " << drop <<" in seconds: " << t2 << endl;
-
-	cout << "Reload test, reloading file: "  << drop << endl;
 	Meshy mesh4(grueCfg);
-//	Segmenter seg4(0.35, 0.35);
-	t0=clock();
-	mesh4.readStlFile( drop.c_str());
-	t1=clock()-t0;
-	cout << "Re-Read: " << target <<" in seconds: " << t1 << endl;
-//	CPP_UNIT_ASSERT(mesh3 == mesh4);
-	cout << "Writing test file: "  << drop2 << endl;
-	mesh4.writeStlFile( drop2.c_str());
-	t2=clock()-t1;
-	cout << "Wrote: " << drop2 <<" in seconds: " << t2 << endl;
+	CPPUNIT_ASSERT_THROW(mesh4.readStlFile(drop.c_str()), MeshyException);
 }
 
 void ModelReaderTestCase::testMeshyCycleMin()
@@ -911,6 +898,299 @@ void ModelReaderTestCase::testAlignToPlate() {
 	
 }
 
+void ModelReaderTestCase::testSliceSweep() {
+    class MeshCfg : public GrueConfig {
+    public:
+        MeshCfg() {
+            layerH = 1.0;
+            firstLayerZ = 1.0;
+        }
+    };
+    MeshCfg grueCfg;
+	Meshy mesh(grueCfg);
+	//triangles of assorted heights, added out of z order
+	Scalar heights[][3] = { {4.5, 9.5, 6}, {0, 2.5, 1}, {0.5, 12.5, 3}, 
+			{6.2, 6.4, 6.3}, {2.5, 7.5, 5} };
+	for (size_t i = 0; i < sizeof(heights) / sizeof(heights[0]); ++i) {
+		Triangle3Type t(Point3Type(0, 0, heights[i][0]), 
+				Point3Type(1, 0, heights[i][1]), 
+				Point3Type(0, 1, heights[i][2]));
+		mesh.addTriangle(t);
+	}
+
+	Segmenter seg(grueCfg);
+	seg.tablaturize(mesh);
+	const SliceTable& table = seg.readSliceTable();
+	CPPUNIT_ASSERT_EQUAL(seg.sliceCount(), table.size());
+	CPPUNIT_ASSERT_EQUAL((size_t)12, table.size());
+	//every triangle, in index order, in each slice it spans
+	for (size_t sliceId = 0; sliceId < table.size(); ++sliceId) {
+		CPPUNIT_ASSERT(std::adjacent_find(table[sliceId].begin(), 
+				table[sliceId].end(), 
+				std::greater_equal<index_t>()) == table[sliceId].end());
+	}
+	CPPUNIT_ASSERT_EQUAL((size_t)2, table[0].size());
+	CPPUNIT_ASSERT_EQUAL((size_t)4, table[5].size());
+	CPPUNIT_ASSERT_EQUAL((size_t)1, table[11].size());
+	CPPUNIT_ASSERT_EQUAL((index_t)2, table[11][0]);
+
+	//a sweep started anywhere agrees with the one from the bottom
+	for (size_t sliceId = 0; sliceId < table.size(); ++sliceId) {
+		SliceSweep sweep(seg, sliceId);
+		for (; sweep.sliceId() < table.size(); sweep.advance()) {
+			CPPUNIT_ASSERT(sweep.triangles() == table[sweep.sliceId()]);
+		}
+	}
+
+	//a partial segmenter agrees within its range
+	Segmenter partial(grueCfg);
+	partial.tablaturize(mesh, 5, 7);
+	CPPUNIT_ASSERT_EQUAL(seg.sliceCount(), partial.sliceCount());
+	for (SliceSweep sweep(partial, 5); sweep.sliceId() < 7; sweep.advance()) {
+		CPPUNIT_ASSERT(sweep.triangles() == table[sweep.sliceId()]);
+	}
+}
+
+static void writeLittleEndian32(ofstream& out, uint32_t val) {
+	for (int i = 0; i < 4; i++)
+		out.put(static_cast<char>((val >> (8 * i)) & 0xff));
+}
+
+/// writes a binary stl of @a faces triangles, each a slice of a fan about 
+/// the origin, with @a header in its 80 byte header and @a count as its 
+/// face count
+static void writeBinaryStl(const string& fileName, const char* header, 
+		uint32_t count, uint32_t faces) {
+	ofstream out(fileName.c_str(), ios::binary);
+	char head[80] = {0};
+	strncpy(head, header, sizeof(head));
+	out.write(head, sizeof(head));
+	writeLittleEndian32(out, count);
+	for (uint32_t face = 0; face < faces; face++) {
+		float coords[12] = { 0, 0, 1, 
+				0, 0, 0, 
+				float(face + 1), 0, 1, 
+				0, float(face + 1), 2 };
+		for (int i = 0; i < 12; i++) {
+			uint32_t bits;
+			memcpy(&bits, &coords[i], 4);
+			writeLittleEndian32(out, bits);
+		}
+		out.put(0);
+		out.put(0);
+	}
+}
+
+void ModelReaderTestCase::testBinarySolidHeader() {
+	GrueConfig grueCfg;
+	//some exporters name the solid in the header of binary files
+	string drop = outputsDir + "SolidHeader.stl";
+	writeBinaryStl(drop, "solid exported", 3, 3);
+	Meshy mesh(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)3, mesh.readStlFile(drop.c_str()));
+	CPPUNIT_ASSERT_EQUAL(3.0, mesh.readAllTriangles()[2][1].x);
+	CPPUNIT_ASSERT_EQUAL(2.0, mesh.readLimits().zMax);
+
+	//without a matching size the header still means ascii
+	writeBinaryStl(drop, "solid exported", 4, 3);
+	Meshy ascii(grueCfg);
+	CPPUNIT_ASSERT_THROW(ascii.readStlFile(drop.c_str()), MeshyException);
+}
+
+static void writeText(const string& fileName, const string& text) {
+	ofstream out(fileName.c_str(), ios::binary);
+	out << text;
+}
+
+/// ascii stl facet with @a a, @a b and @a c as its vertex coordinates
+static string asciiFacet(const string& a, const string& b, const string& c) {
+	return "facet normal 0 0 1\n outer loop\n  vertex " + a + "\n  vertex " + 
+			b + "\n  vertex " + c + "\n endloop\nendfacet\n";
+}
+
+static Scalar coordinate(const Point3Type& point, int axis) {
+	return axis == 0 ? point.x : (axis == 1 ? point.y : point.z);
+}
+
+class StrictCfg : public GrueConfig {
+public:
+	StrictCfg() {
+		strictStl = true;
+	}
+};
+
+void ModelReaderTestCase::testTruncatedBinary() {
+	GrueConfig grueCfg;
+	string drop = outputsDir + "Truncated.stl";
+
+	//the header promises more faces than the file holds
+	writeBinaryStl(drop, "binary", 1000, 5);
+	Meshy mesh(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)5, mesh.readStlFile(drop.c_str()));
+	CPPUNIT_ASSERT_EQUAL(5.0, mesh.readAllTriangles()[4][1].x);
+
+	//even more than could be allocated
+	writeBinaryStl(drop, "binary", 0xffffffff, 2);
+	Meshy huge(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, huge.readStlFile(drop.c_str()));
+
+	//records past the count are left out
+	writeBinaryStl(drop, "binary", 3, 5);
+	Meshy shorter(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)3, shorter.readStlFile(drop.c_str()));
+
+	//a file cut inside its header is rejected
+	writeText(drop, "binary");
+	Meshy headless(grueCfg);
+	CPPUNIT_ASSERT_THROW(headless.readStlFile(drop.c_str()), MeshyException);
+}
+
+void ModelReaderTestCase::testLargeBinary() {
+	GrueConfig grueCfg;
+	//enough faces to be decoded in parallel
+	const uint32_t faces = 70000;
+	string drop = outputsDir + "Large.stl";
+	writeBinaryStl(drop, "binary", faces, faces);
+	Meshy mesh(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)faces, mesh.readStlFile(drop.c_str()));
+	const std::vector<Triangle3Type>& triangles = mesh.readAllTriangles();
+	for (uint32_t face = 0; face < faces; face++) {
+		CPPUNIT_ASSERT_EQUAL(0.0, triangles[face][0].z);
+		CPPUNIT_ASSERT_EQUAL(Scalar(face + 1), triangles[face][1].x);
+		CPPUNIT_ASSERT_EQUAL(Scalar(face + 1), triangles[face][2].y);
+		CPPUNIT_ASSERT_EQUAL(2.0, triangles[face][2].z);
+	}
+	CPPUNIT_ASSERT_EQUAL(Scalar(faces), mesh.readLimits().xMax);
+	CPPUNIT_ASSERT_EQUAL(1.0, triangles[faces - 1][1].z);
+}
+
+void ModelReaderTestCase::testAsciiSpellings() {
+	string drop = outputsDir + "Spellings.stl";
+	writeText(drop, "SOLID Shouting\r\n"
+			"  FACET NORMAL 0 0 1E+0\r\n"
+			"    OUTER LOOP\r\n"
+			"      VERTEX 1E0 2.5e-1 -3E+2\r\n"
+			"      VERTEX 4.0E1 5 6\r\n"
+			"      VERTEX 7 8e-3 9.5E1\r\n"
+			"    ENDLOOP\r\n"
+			"  EndFacet\r\n"
+			"ENDSOLID Shouting\r\n");
+	StrictCfg strictCfg;
+	GrueConfig lenientCfg;
+	for (int strict = 0; strict < 2; strict++) {
+		Meshy mesh(strict ? strictCfg : lenientCfg);
+		CPPUNIT_ASSERT_EQUAL((size_t)1, mesh.readStlFile(drop.c_str()));
+		const Triangle3Type& triangle = mesh.readAllTriangles()[0];
+		CPPUNIT_ASSERT_EQUAL(1.0, triangle[0].x);
+		CPPUNIT_ASSERT_EQUAL(Scalar(2.5e-1f), triangle[0].y);
+		CPPUNIT_ASSERT_EQUAL(-300.0, triangle[0].z);
+		CPPUNIT_ASSERT_EQUAL(40.0, triangle[1].x);
+		CPPUNIT_ASSERT_EQUAL(Scalar(8e-3f), triangle[2].y);
+		CPPUNIT_ASSERT_EQUAL(95.0, triangle[2].z);
+	}
+}
+
+void ModelReaderTestCase::testStrictStl() {
+	StrictCfg strictCfg;
+	GrueConfig lenientCfg;
+	string drop = outputsDir + "Strict.stl";
+	string good = asciiFacet("0 0 0", "1 0 0", "0 1 0");
+
+	//a misspelled keyword is only counted when lenient
+	string misspelled = good;
+	misspelled.replace(misspelled.find("outer"), 5, "outre");
+	writeText(drop, "solid s\n" + good + misspelled + "endsolid s\n");
+	Meshy strictSpelling(strictCfg);
+	CPPUNIT_ASSERT_THROW(strictSpelling.readStlFile(drop.c_str()), 
+			MeshyException);
+	Meshy lenientSpelling(lenientCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, lenientSpelling.readStlFile(drop.c_str()));
+
+	//a file cut off keeps its complete facets when lenient
+	string cut = "solid s\n" + good + good;
+	writeText(drop, cut);
+	Meshy strictEnd(strictCfg);
+	CPPUNIT_ASSERT_THROW(strictEnd.readStlFile(drop.c_str()), MeshyException);
+	Meshy lenientEnd(lenientCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, lenientEnd.readStlFile(drop.c_str()));
+	writeText(drop, cut + good.substr(0, good.find("endloop")));
+	Meshy strictFacet(strictCfg);
+	CPPUNIT_ASSERT_THROW(strictFacet.readStlFile(drop.c_str()), 
+			MeshyException);
+	Meshy lenientFacet(lenientCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, lenientFacet.readStlFile(drop.c_str()));
+
+	//a bad number is an error either way
+	writeText(drop, "solid s\n" + asciiFacet("0 0 0", "1 0 x", "0 1 0") + 
+			good + "endsolid s\n");
+	Meshy strictNumber(strictCfg);
+	CPPUNIT_ASSERT_THROW(strictNumber.readStlFile(drop.c_str()), 
+			MeshyException);
+	Meshy lenientNumber(lenientCfg);
+	CPPUNIT_ASSERT_THROW(lenientNumber.readStlFile(drop.c_str()), 
+			MeshyException);
+}
+
+void ModelReaderTestCase::testAsciiNumbers() {
+	//spellings on either side of the exact fast path, which must agree 
+	//with strtof
+	const char* numbers[] = { "0", "-0", "1", "0.1", "-0.1", 
+			"3.14159265358979", "16777216", "16777217", "33554433", 
+			"0.30000000000000004", "123456.789", "1e10", "1e11", "1e-10", 
+			"1e-11", "1.5e-45", "3.4028235e38", ".5", "5.", "+1.5", "7e22", 
+			"0.000001", "1234567890123456789", "12345678901234567890", 
+			"9007199254740993", "2.5E-3", "-6.02e23", "1.17549435e-38", 
+			"100000000000", "0.00000000001", "2", "-2.5", "1e0", "1E+1", 
+			"10e-1", "0000000000000000000001.5" };
+	const size_t count = sizeof(numbers) / sizeof(numbers[0]);
+	CPPUNIT_ASSERT_EQUAL((size_t)0, count % 9);
+
+	string text = "solid numbers\n";
+	for (size_t i = 0; i < count; i += 9) {
+		string v[3];
+		for (int j = 0; j < 3; j++) {
+			v[j] = string(numbers[i + 3 * j]) + " " + numbers[i + 3 * j + 1] + 
+					" " + numbers[i + 3 * j + 2];
+		}
+		text += asciiFacet(v[0], v[1], v[2]);
+	}
+	text += "endsolid numbers\n";
+	string drop = outputsDir + "Numbers.stl";
+	writeText(drop, text);
+
+	GrueConfig grueCfg;
+	Meshy mesh(grueCfg);
+	CPPUNIT_ASSERT_EQUAL(count / 9, mesh.readStlFile(drop.c_str()));
+	const std::vector<Triangle3Type>& triangles = mesh.readAllTriangles();
+	for (size_t i = 0; i < count; i++) {
+		Scalar expected = strtof(numbers[i], NULL);
+		Scalar read = coordinate(triangles[i / 9][(i / 3) % 3], i % 3);
+		CPPUNIT_ASSERT_EQUAL(expected, read);
+	}
+}
+
+#ifndef WIN32
+void ModelReaderTestCase::testReadFromPipe() {
+	//pipes cannot be mapped and tell their size only at the end
+	string pipe = outputsDir + "Pipe.stl";
+	unlink(pipe.c_str());
+	CPPUNIT_ASSERT_EQUAL(0, mkfifo(pipe.c_str(), 0600));
+	string text = "solid piped\n" + asciiFacet("0 0 0", "1 0 0", "0 1 0") + 
+			asciiFacet("0 0 1", "2 0 1", "0 2 1") + "endsolid piped\n";
+	pid_t writer = fork();
+	if (writer == 0) {
+		writeText(pipe, text);
+		_exit(0);
+	}
+	GrueConfig grueCfg;
+	Meshy mesh(grueCfg);
+	CPPUNIT_ASSERT_EQUAL((size_t)2, mesh.readStlFile(pipe.c_str()));
+	waitpid(writer, NULL, 0);
+	unlink(pipe.c_str());
+	CPPUNIT_ASSERT_EQUAL(2.0, mesh.readAllTriangles()[1][1].x);
+}
+#endif
+
 void initConfig(Configuration &config)
 {
 	config["slicer"]["firstLayerZ"] = 0.11;
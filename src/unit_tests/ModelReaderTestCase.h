@@ -35,6 +35,16 @@ class ModelReaderTestCase : public CPPUNIT_NS::TestFixture
 //	  CPPUNIT_TEST( testMeshySimple );
 //	  CPPUNIT_TEST( testKnot);
 	CPPUNIT_TEST( testAlignToPlate );
+	CPPUNIT_TEST( testSliceSweep );
+	CPPUNIT_TEST( testBinarySolidHeader );
+	CPPUNIT_TEST( testTruncatedBinary );
+	CPPUNIT_TEST( testLargeBinary );
+	CPPUNIT_TEST( testAsciiSpellings );
+	CPPUNIT_TEST( testStrictStl );
+	CPPUNIT_TEST( testAsciiNumbers );
+#ifndef WIN32
+	CPPUNIT_TEST( testReadFromPipe );
+#endif
   CPPUNIT_TEST_SUITE_END();
 
 
@@ -68,6 +78,16 @@ protected:
   void fixContourProblem();
   void testKnot();
 	void testAlignToPlate();
+	void testSliceSweep();
+	void testBinarySolidHeader();
+	void testTruncatedBinary();
+	void testLargeBinary();
+	void testAsciiSpellings();
+	void testStrictStl();
+	void testAsciiNumbers();
+#ifndef WIN32
+	void testReadFromPipe();
+#endif
 };
 
 
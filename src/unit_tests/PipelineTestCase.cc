@@ -0,0 +1,172 @@
+#include <sstream>
+#include <iomanip>
+
+#include <cppunit/config/SourcePrefix.h>
+
+#include "UnitTestUtils.h"
+#include "PipelineTestCase.h"
+
+#include "mgl/configuration.h"
+#include "mgl/miracle.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PipelineTestCase );
+
+using namespace std;
+using namespace mgl;
+
+static const char* CONFIG_FILE = "miracle.config";
+static const char* KNOT_FILE = "inputs/3D_Knot.stl";
+static const char* BOX_FILE = "inputs/20mm_Calibration_Box.stl";
+
+static void loadConfig(GrueConfig& grueCfg, bool raft, bool stream = false) {
+	Configuration config;
+	config.readFromFile(CONFIG_FILE);
+	config["doRaft"] = raft;
+	config["streamLayers"] = stream;
+	grueCfg.loadFromFile(config);
+}
+
+/// run the whole pipeline on layers [first, last], -1 for either end
+static void runModel(const GrueConfig& grueCfg, const char* modelFile,
+		int first, int last, RegionList& regions) {
+	std::vector<SliceData> slices;
+	ostringstream gcode;
+	try {
+		miracleGrue(grueCfg, modelFile, NULL, gcode, first, last,
+				regions, slices);
+	} catch (const mgl::Exception& mgle) {
+		CPPUNIT_FAIL(mgle.error);
+	}
+}
+
+/// the G-code of layers [first, last], without the progress lines, which 
+/// count differently when streaming, and the dated header
+static string runGcode(const GrueConfig& grueCfg, const char* modelFile,
+		int first, int last) {
+	RegionList regions;
+	std::vector<SliceData> slices;
+	ostringstream gcode;
+	try {
+		miracleGrue(grueCfg, modelFile, NULL, gcode, first, last,
+				regions, slices);
+	} catch (const mgl::Exception& mgle) {
+		CPPUNIT_FAIL(mgle.error);
+	}
+	istringstream lines(gcode.str());
+	ostringstream kept;
+	string line;
+	while (getline(lines, line)) {
+		if (line.compare(0, 3, "M73") != 0 && line.compare(0, 2, ";*") != 0)
+			kept << line << "\n";
+	}
+	return kept.str();
+}
+
+/// streaming layers [first, last] gives the G-code of running them at once
+static void checkStreamed(bool raft, const char* modelFile,
+		int first, int last) {
+	GrueConfig batchCfg;
+	loadConfig(batchCfg, raft);
+	GrueConfig streamCfg;
+	loadConfig(streamCfg, raft, true);
+	string batch = runGcode(batchCfg, modelFile, first, last);
+	CPPUNIT_ASSERT(!batch.empty());
+	CPPUNIT_ASSERT(batch == runGcode(streamCfg, modelFile, first, last));
+}
+
+static void writeLoops(ostream& out, const LoopList& loops) {
+	for (LoopList::const_iterator loop = loops.begin();
+			loop != loops.end(); ++loop) {
+		for (Loop::const_finite_cw_iterator point = loop->clockwiseFinite();
+				point != loop->clockwiseEnd(); ++point) {
+			out << Point2Type(*point).x << "," << Point2Type(*point).y << " ";
+		}
+		out << "\n";
+	}
+}
+
+static void writeRanges(ostream& out, const ScalarRangeTable& rays) {
+	for (size_t ray = 0; ray < rays.size(); ++ray) {
+		ScalarRangeLine line = rays[ray];
+		for (ScalarRangeLine::const_iterator range = line.begin();
+				range != line.end(); ++range) {
+			out << range->min << ":" << range->max << " ";
+		}
+		out << "\n";
+	}
+}
+
+/// everything the pather reads from a layer, as text
+static string describeLayer(const LayerRegions& layer) {
+	ostringstream out;
+	out << setprecision(17) << "measure " << layer.layerMeasureId << "\n";
+	writeLoops(out, layer.outlines);
+	for (std::list<LoopList>::const_iterator shell = layer.insetLoops.begin();
+			shell != layer.insetLoops.end(); ++shell) {
+		out << "inset\n";
+		writeLoops(out, *shell);
+	}
+	out << "support\n";
+	writeLoops(out, layer.supportLoops);
+	out << "interior\n";
+	writeLoops(out, layer.interiorLoops);
+	out << "infill\n";
+	writeRanges(out, layer.infill.xRays);
+	writeRanges(out, layer.infill.yRays);
+	writeRanges(out, layer.support.xRays);
+	writeRanges(out, layer.support.yRays);
+	return out.str();
+}
+
+/// layers [first, last] of a partial run must be those of the whole run
+static void checkPartialRange(const GrueConfig& grueCfg,
+		const char* modelFile, const RegionList& whole,
+		size_t first, size_t last) {
+	RegionList partial;
+	runModel(grueCfg, modelFile, first, last, partial);
+	CPPUNIT_ASSERT_EQUAL(whole.size(), partial.size());
+	for (size_t layer = first; layer <= last; ++layer) {
+		CPPUNIT_ASSERT_EQUAL(describeLayer(whole[layer]),
+				describeLayer(partial[layer]));
+	}
+}
+
+void PipelineTestCase::testPartialRange() {
+	GrueConfig grueCfg;
+	loadConfig(grueCfg, false);
+	RegionList whole;
+	runModel(grueCfg, KNOT_FILE, -1, -1, whole);
+	checkPartialRange(grueCfg, KNOT_FILE, whole, 0, 3);
+	checkPartialRange(grueCfg, KNOT_FILE, whole, 60, 65);
+	checkPartialRange(grueCfg, KNOT_FILE, whole,
+			whole.size() - 4, whole.size() - 1);
+}
+
+void PipelineTestCase::testPartialRangeWithRaft() {
+	GrueConfig grueCfg;
+	loadConfig(grueCfg, true);
+	size_t raftLayers = grueCfg.get_raftLayers();
+	RegionList whole;
+	runModel(grueCfg, KNOT_FILE, -1, -1, whole);
+	//raft layers are built from the bottom slice, even when it is not
+	//in the range
+	checkPartialRange(grueCfg, KNOT_FILE, whole, 0, raftLayers + 1);
+	checkPartialRange(grueCfg, KNOT_FILE, whole, 60, 65);
+
+	RegionList box;
+	runModel(grueCfg, BOX_FILE, -1, -1, box);
+	checkPartialRange(grueCfg, BOX_FILE, box, 6, 10);
+}
+
+void PipelineTestCase::testStreamedMatchesBatch() {
+	checkStreamed(false, KNOT_FILE, -1, -1);
+	checkStreamed(true, KNOT_FILE, -1, -1);
+	checkStreamed(false, BOX_FILE, -1, -1);
+}
+
+void PipelineTestCase::testStreamedPartialRange() {
+	//batch ranges regenerate the layers of the whole model, see above
+	checkStreamed(false, KNOT_FILE, 20, 60);
+	checkStreamed(true, KNOT_FILE, 60, 65);
+	checkStreamed(true, BOX_FILE, 6, 10);
+}
@@ -0,0 +1,27 @@
+#ifndef PIPELINE_TEST_CASE_H
+#define PIPELINE_TEST_CASE_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+
+
+class PipelineTestCase : public CPPUNIT_NS::TestFixture
+{
+	CPPUNIT_TEST_SUITE( PipelineTestCase );
+		CPPUNIT_TEST( testPartialRange );
+		CPPUNIT_TEST( testPartialRangeWithRaft );
+		CPPUNIT_TEST( testStreamedMatchesBatch );
+		CPPUNIT_TEST( testStreamedPartialRange );
+	CPPUNIT_TEST_SUITE_END();
+
+protected:
+
+	void testPartialRange();
+	void testPartialRangeWithRaft();
+	void testStreamedMatchesBatch();
+	void testStreamedPartialRange();
+
+};
+
+
+#endif
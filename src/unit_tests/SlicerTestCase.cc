@@ -17,6 +17,7 @@
 #include "mgl/shrinky.h"
 #include "mgl/meshy.h"
 #include "mgl/gcoder.h"
+#include "mgl/segment.h"
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SlicerTestCase);
 
@@ -877,6 +878,176 @@ void SlicerTestCase::testSliceTriangle() {
 
 
 
+}
+
+void SlicerTestCase::testBatchSegmentation() {
+    cout << endl << "Testing batched segmentation..." << endl;
+
+    // every order of vertices crossing, touching and lying on z = 1
+    Scalar heights[] = { 0, 1, 2, 1 + 1e-7, 3 };
+    size_t heightCount = sizeof(heights) / sizeof(heights[0]);
+    std::vector<Triangle3Type> allTriangles;
+    for (size_t i = 0; i < heightCount; ++i)
+        for (size_t j = 0; j < heightCount; ++j)
+            for (size_t k = 0; k < heightCount; ++k) {
+                allTriangles.push_back(Triangle3Type(
+                        Point3Type(0, 0, heights[i]),
+                        Point3Type(3, 1, heights[j]),
+                        Point3Type(1, 4, heights[k])));
+                // and wound the other way
+                allTriangles.push_back(Triangle3Type(
+                        Point3Type(0, 0, heights[i]),
+                        Point3Type(1, 4, heights[k]),
+                        Point3Type(3, 1, heights[j])));
+            }
+    // every triangle twice, the second time backward, so the slice 
+    // spans more than one batch and batches are gathered out of order
+    TriangleIndices trianglesForSlice;
+    for (size_t i = 0; i < allTriangles.size(); ++i)
+        trianglesForSlice.push_back(i);
+    for (size_t i = allTriangles.size(); i-- > 0;)
+        trianglesForSlice.push_back(i);
+
+    for (Scalar z = 0.5; z < 3; z += 0.5) {
+        std::vector<Segment2Type> expected;
+        segmentationOfTriangles(trianglesForSlice, allTriangles, z, expected);
+        std::vector<Segment2Type> segments;
+        segmentationOfTrianglesInBatches(trianglesForSlice, allTriangles, z,
+                segments);
+        CPPUNIT_ASSERT(!expected.empty());
+        CPPUNIT_ASSERT_EQUAL(expected.size(), segments.size());
+        for (size_t i = 0; i < segments.size(); ++i) {
+            // same arithmetic, so no tolerance
+            CPPUNIT_ASSERT(expected[i].a.x == segments[i].a.x);
+            CPPUNIT_ASSERT(expected[i].a.y == segments[i].a.y);
+            CPPUNIT_ASSERT(expected[i].b.x == segments[i].b.x);
+            CPPUNIT_ASSERT(expected[i].b.y == segments[i].b.y);
+        }
+    }
+}
+
+// the exhaustive search of segment.cc that loopsAndHoleOgy falls back to
+Scalar findClosestLineSegment2(const Point2Type& endOfPreviousLineSegment2,
+        vector<Segment2Type>::iterator startIt,
+        vector<Segment2Type>::iterator endIt,
+        vector<Segment2Type>::iterator &bestSegmentIt);
+
+// loopsAndHoleOgy without its grid of start points: every hop scans all 
+// the segments left
+static void exhaustiveLoops(std::vector<Segment2Type> segments, Scalar tol,
+        SegmentTable &loops) {
+    std::vector<Scalar> hops(1, 0);
+    for (size_t i = 0; i + 1 < segments.size(); ++i) {
+        vector<Segment2Type>::iterator best;
+        Scalar hop = findClosestLineSegment2(segments[i].b, 
+                segments.begin() + i + 1, segments.end(), best);
+        CPPUNIT_ASSERT(best != segments.end());
+        swap(segments[i + 1], *best);
+        hops.push_back(hop);
+    }
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (i == 0 || !(hops[i] < tol))
+            loops.push_back(std::vector<Segment2Type>());
+        loops.back().push_back(segments[i]);
+    }
+}
+
+static void addSegment(std::vector<Segment2Type> &segments, 
+        Scalar ax, Scalar ay, Scalar bx, Scalar by) {
+    Segment2Type s;
+    s.a = Point2Type(ax, ay);
+    s.b = Point2Type(bx, by);
+    segments.push_back(s);
+}
+
+// the same shuffle everywhere, unlike random_shuffle
+static void shuffleSegments(std::vector<Segment2Type> &segments, 
+        unsigned seed) {
+    for (size_t i = segments.size(); i > 1; --i) {
+        seed = seed * 1103515245u + 12345u;
+        swap(segments[i - 1], segments[(seed >> 8) % i]);
+    }
+}
+
+static void checkChaining(const std::vector<Segment2Type> &segments, 
+        Scalar tol) {
+    SegmentTable expected;
+    exhaustiveLoops(segments, tol, expected);
+    std::vector<Segment2Type> chained = segments;
+    SegmentTable loops;
+    loopsAndHoleOgy(chained, tol, loops);
+    CPPUNIT_ASSERT_EQUAL(expected.size(), loops.size());
+    for (size_t i = 0; i < loops.size(); ++i) {
+        CPPUNIT_ASSERT_EQUAL(expected[i].size(), loops[i].size());
+        for (size_t j = 0; j < loops[i].size(); ++j) {
+            CPPUNIT_ASSERT(expected[i][j].a == loops[i][j].a);
+            CPPUNIT_ASSERT(expected[i][j].b == loops[i][j].b);
+        }
+    }
+}
+
+void SlicerTestCase::testLoopChaining() {
+    cout << endl << "Testing loop chaining..." << endl;
+
+    std::vector<Segment2Type> segments;
+    // three squares sharing the corner at the origin, so hops to the 
+    // start of two others tie at 0
+    for (int quadrant = 0; quadrant < 3; ++quadrant) {
+        Scalar sx = quadrant == 1 ? -1 : 1;
+        Scalar sy = quadrant == 2 ? -1 : 1;
+        addSegment(segments, 0, 0, sx, 0);
+        addSegment(segments, sx, 0, sx, sy);
+        addSegment(segments, sx, sy, 0, sy);
+        addSegment(segments, 0, sy, 0, 0);
+    }
+    // a gap of 0.25 with starts on either side of it: ties at 0.0625
+    addSegment(segments, 4, 0, 5, 0);
+    addSegment(segments, 5.25, 0, 6, 0);
+    addSegment(segments, 4.75, 0, 4.75, 1);
+    addSegment(segments, 6, 0, 4, 0);
+    addSegment(segments, 4.75, 1, 4, 0);
+    // squares far apart, closed by hops much longer than tol
+    for (int far = 1; far <= 3; ++far) {
+        Scalar x = 100 * far;
+        addSegment(segments, x, 0, x + 2, 0);
+        addSegment(segments, x + 2, 0, x + 2, 2);
+        addSegment(segments, x + 2, 2, x, 2);
+        addSegment(segments, x, 2, x, 0);
+    }
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        std::vector<Segment2Type> shuffled = segments;
+        shuffleSegments(shuffled, seed);
+        checkChaining(shuffled, 0.1);
+    }
+
+    // a real slice, with the tolerance of the slicer
+    class MeshCfg : public GrueConfig {
+    public:
+        MeshCfg() {
+            firstLayerZ = 0;
+            layerH = 0.35;
+            doPutModelOnPlatform = true;
+        }
+    };
+    MeshCfg grueCfg;
+    Meshy mesh(grueCfg);
+    Segmenter seg(grueCfg);
+    mesh.readStlFile("inputs/3D_Knot.stl");
+    seg.tablaturize(mesh);
+    const SliceTable &sliceTable = seg.readSliceTable();
+    size_t sliceIds[] = { 0, 26, 44, 57, 89 };
+    for (size_t i = 0; i < sizeof(sliceIds) / sizeof(sliceIds[0]); ++i) {
+        CPPUNIT_ASSERT(sliceIds[i] < sliceTable.size());
+        std::vector<Segment2Type> slice;
+        segmentationOfTriangles(sliceTable[sliceIds[i]], 
+                mesh.readAllTriangles(), 
+                seg.readLayerMeasure().sliceIndexToHeight(sliceIds[i]), 
+                slice);
+        CPPUNIT_ASSERT(!slice.empty());
+        checkChaining(slice, 1e-6);
+        shuffleSegments(slice, unsigned(sliceIds[i]));
+        checkChaining(slice, 1e-6);
+    }
 }
 
 void SlicerTestCase::testFutureSlice() {
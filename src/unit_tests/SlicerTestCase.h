@@ -25,6 +25,8 @@ private:
         CPPUNIT_TEST( testInset3 );
         CPPUNIT_TEST( testHexagon);
         CPPUNIT_TEST( testSliceTriangle );
+        CPPUNIT_TEST( testBatchSegmentation );
+        CPPUNIT_TEST( testLoopChaining );
 
 		CPPUNIT_TEST( testOpenPoly );
 		CPPUNIT_TEST( testSquareBug );
@@ -69,6 +71,8 @@ protected:
   void testCut();
   void testAngles();
   void testSliceTriangle();
+  void testBatchSegmentation();
+  void testLoopChaining();
   void testSliceTriangle2();
 
   void testInset();
@@ -8,7 +8,9 @@
 #include "mgl/intersection_index.h"
 #include "mgl/basic_boxlist.h"
 #include "mgl/basic_rtree.h"
+#include "mgl/basic_strtree.h"
 #include "mgl/basic_quadtree.h"
+#include "mgl/regioner.h"
 #include <cmath>
 #include <ctime>
 
@@ -251,6 +253,175 @@ void SpacialTestCase::testRtreeStress() {
     CPPUNIT_ASSERT_EQUAL(finalBrute.size(), finalFiltered.size());
 }
 
+class CrossesLine {
+public:
+    CrossesLine(const Segment2Type& line) : m_line(line) {}
+    bool operator()(const Segment2Type& other) const {
+        return m_line.intersects(other);
+    }
+private:
+    Segment2Type m_line;
+};
+
+void SpacialTestCase::testStrtreeFilter() {
+    typedef basic_strtree<Segment2Type> lineIndexType;
+    typedef std::vector<Segment2Type> simpleCollectionType;
+    std::cout << "Testing filtering of things" << std::endl;
+    lineIndexType lines;
+    Segment2Type testLine(Point2Type(-0.5,0.1), Point2Type(-0.5,2));
+    simpleCollectionType result;
+    lines.search(result, LineSegmentFilter(testLine));
+    CPPUNIT_ASSERT(result.empty());
+    CPPUNIT_ASSERT(!lines.any(LineSegmentFilter(testLine), 
+            CrossesLine(testLine)));
+    Segment2Type line1(Point2Type(-1,0), Point2Type(0,1));
+    Segment2Type line2(Point2Type(-1,1), Point2Type(0,2));
+    Segment2Type line3(Point2Type(0,1), Point2Type(1,0));
+    std::cout << "Inserting the things" << std::endl;
+    lines.insert(line1);
+    lines.insert(line2);
+    lines.insert(line3);
+    std::cout << "Testing the things" << std::endl;
+    lines.search(result, LineSegmentFilter(testLine));
+    size_t expected = 2;
+    CPPUNIT_ASSERT_EQUAL(expected, result.size());
+    CPPUNIT_ASSERT(lines.any(LineSegmentFilter(testLine), 
+            CrossesLine(testLine)));
+    Segment2Type missLine(Point2Type(0.5,0.6), Point2Type(0.5,2));
+    CPPUNIT_ASSERT(!lines.any(LineSegmentFilter(missLine), 
+            CrossesLine(missLine)));
+    std::cout << "Inserting after searching" << std::endl;
+    lines.insert(Segment2Type(Point2Type(0,1.5), Point2Type(1,1.5)));
+    CPPUNIT_ASSERT(lines.any(LineSegmentFilter(missLine), 
+            CrossesLine(missLine)));
+}
+
+void SpacialTestCase::testStrtreeStress() {
+    typedef basic_strtree<Segment2Type> lineIndexType;
+    typedef std::vector<Segment2Type> simpleCollectionType;
+    srand(0);
+    simpleCollectionType dataset;
+    std::cout << "Making " << TEST_SET_SIZE << " lines" << std::endl;
+    Scalar range = 500;
+    Scalar range2 = 50;
+    for(size_t i=0; i < TEST_SET_SIZE; ++i) {
+        dataset.push_back(randSegment(range, range2));
+    }
+    lineIndexType strtree;
+    basic_boxlist<Segment2Type> boxlist;
+    for(simpleCollectionType::const_iterator iter = dataset.begin(); 
+            iter != dataset.end(); 
+            ++iter) {
+        strtree.insert(*iter);
+        boxlist.insert(*iter);
+    }
+    std::cout << "Comparing against boxlist" << std::endl;
+    for(size_t i = 0; i < 100; ++i) {
+        Segment2Type testLine = randSegment(range, range2);
+        simpleCollectionType treeResult;
+        simpleCollectionType listResult;
+        strtree.search(treeResult, LineSegmentFilter(testLine));
+        boxlist.search(listResult, LineSegmentFilter(testLine));
+        CPPUNIT_ASSERT_EQUAL(listResult.size(), treeResult.size());
+        CPPUNIT_ASSERT_EQUAL(
+                boxlist.any(LineSegmentFilter(testLine), 
+                CrossesLine(testLine)), 
+                strtree.any(LineSegmentFilter(testLine), 
+                CrossesLine(testLine)));
+    }
+}
+
+void SpacialTestCase::testAny() {
+    srand(0);
+    Scalar range = 100;
+    Scalar range2 = 10;
+    AABBox quadBounds(Point2Type(-range2, -range2), 
+            Point2Type(range + range2, range + range2));
+    basic_boxlist<Segment2Type> boxlist;
+    basic_rtree<Segment2Type> rtree;
+    basic_quadtree<Segment2Type> quadtree(quadBounds);
+    basic_strtree<Segment2Type> strtree;
+    Segment2Type testLine = randSegment(range, range2);
+    CPPUNIT_ASSERT(!rtree.any(LineSegmentFilter(testLine), 
+            CrossesLine(testLine)));
+    CPPUNIT_ASSERT(!quadtree.any(LineSegmentFilter(testLine), 
+            CrossesLine(testLine)));
+    for(size_t i = 0; i < 2000; ++i) {
+        Segment2Type segment = randSegment(range, range2);
+        boxlist.insert(segment);
+        rtree.insert(segment);
+        quadtree.insert(segment);
+        strtree.insert(segment);
+    }
+    std::cout << "Comparing any against boxlist" << std::endl;
+    size_t found = 0;
+    for(size_t i = 0; i < 300; ++i) {
+        //short lines, so that some cross nothing
+        testLine = randSegment(range, 0.2 * range2);
+        bool expected = boxlist.any(LineSegmentFilter(testLine), 
+                CrossesLine(testLine));
+        CPPUNIT_ASSERT_EQUAL(expected, rtree.any(LineSegmentFilter(testLine), 
+                CrossesLine(testLine)));
+        CPPUNIT_ASSERT_EQUAL(expected, quadtree.any(
+                LineSegmentFilter(testLine), CrossesLine(testLine)));
+        CPPUNIT_ASSERT_EQUAL(expected, strtree.any(
+                LineSegmentFilter(testLine), CrossesLine(testLine)));
+        if(expected)
+            ++found;
+    }
+    CPPUNIT_ASSERT(found > 0);
+    CPPUNIT_ASSERT(found < 300);
+}
+
+static void assertSameSegments(const std::vector<Segment2Type>& expected, 
+        const std::vector<Segment2Type>& actual) {
+    CPPUNIT_ASSERT_EQUAL(expected.size(), actual.size());
+    for(size_t i = 0; i < expected.size(); ++i) {
+        CPPUNIT_ASSERT(expected[i].a == actual[i].a);
+        CPPUNIT_ASSERT(expected[i].b == actual[i].b);
+    }
+}
+
+void SpacialTestCase::testSegmentIndex() {
+    typedef std::vector<Segment2Type> simpleCollectionType;
+    srand(0);
+    Scalar range = 100;
+    Scalar range2 = 10;
+    SegmentIndex index;
+    basic_boxlist<Segment2Type> boxlist;
+    for(size_t i = 0; i < 2000; ++i) {
+        Segment2Type segment = randSegment(range, range2);
+        index.insert(segment);
+        boxlist.insert(segment);
+    }
+    std::cout << "Comparing against boxlist, in insertion order" << std::endl;
+    for(size_t i = 0; i < 200; ++i) {
+        Segment2Type testLine = randSegment(range, range2);
+        simpleCollectionType indexResult;
+        simpleCollectionType listResult;
+        index.search(indexResult, LineSegmentFilter(testLine));
+        boxlist.search(listResult, LineSegmentFilter(testLine));
+        assertSameSegments(listResult, indexResult);
+        //insertions after searching are found too
+        Segment2Type segment = randSegment(range, range2);
+        index.insert(segment);
+        boxlist.insert(segment);
+    }
+    std::cout << "Erasing" << std::endl;
+    Segment2Type erased(Point2Type(0, 0), Point2Type(1, 1));
+    index.insert(erased);
+    simpleCollectionType before;
+    index.search(before, LineSegmentFilter(erased));
+    CPPUNIT_ASSERT_EQUAL((size_t) 1, index.erase(erased));
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, index.erase(erased));
+    simpleCollectionType after;
+    index.search(after, LineSegmentFilter(erased));
+    CPPUNIT_ASSERT_EQUAL(before.size() - 1, after.size());
+    for(size_t i = 0; i < after.size(); ++i) {
+        CPPUNIT_ASSERT(!(after[i].a == erased.a && after[i].b == erased.b));
+    }
+}
+
 void SpacialTestCase::testQtreeFilter() {
     typedef basic_quadtree<Segment2Type> lineIndexType;
     typedef std::vector<Segment2Type> simpleCollectionType;
@@ -28,6 +28,10 @@ private:
 //    CPPUNIT_TEST( testQtreeFilter );
 //    CPPUNIT_TEST( testQtreeEmpty );
 //    CPPUNIT_TEST( testQtreeStress );
+    CPPUNIT_TEST( testStrtreeFilter );
+    CPPUNIT_TEST( testStrtreeStress );
+    CPPUNIT_TEST( testAny );
+    CPPUNIT_TEST( testSegmentIndex );
     CPPUNIT_TEST( testPerformance );
 //    CPPUNIT_TEST( testQPerformance );
     CPPUNIT_TEST_SUITE_END();
@@ -42,6 +46,10 @@ protected:
     void testRtreeFilter();
     void testRtreeEmpty();
     void testRtreeStress();
+    void testStrtreeFilter();
+    void testStrtreeStress();
+    void testAny();
+    void testSegmentIndex();
     void testQtreeFilter();
     void testQtreeEmpty();
     void testQtreeStress();